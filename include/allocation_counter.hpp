@@ -0,0 +1,17 @@
+//============================================================================
+// Name        : allocation_counter.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef ALLOCATION_COUNTER_HPP_
+#define ALLOCATION_COUNTER_HPP_
+
+/**
+ * Number of allocations made by the global operator new since the start of
+ * the program, in all threads. Used to check that insertion does not
+ * allocate memory.
+ */
+unsigned long allocationCount();
+
+#endif /* ALLOCATION_COUNTER_HPP_ */
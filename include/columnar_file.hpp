@@ -0,0 +1,128 @@
+//============================================================================
+// Name        : columnar_file.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef COLUMNAR_FILE_HPP_
+#define COLUMNAR_FILE_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cuboid.hpp"
+#include "mapped_file.hpp"
+#include "rect.hpp"
+
+/**
+ * Header of a binary columnar file of cuboids (.bpc). The header is
+ * followed by columns of count values each, every column starts at a
+ * multiple of columnAlignment bytes:
+ *  - items (input cuboids): width, height, depth (float),
+ *  - placements (placed cuboids): id (uint32_t), orientation (uint8_t, a row
+ *    of itemOrientations), container (uint32_t), x, y, z (float) of the
+ *    corner with the lowest coordinates.
+ * Values are stored in the byte order of the machine which wrote the file,
+ * the header records it.
+ */
+struct ColumnarHeader
+{
+	char magic[4];
+	/* byteOrderMark as written, another value means the other byte order. */
+	uint32_t byteOrder;
+	uint32_t version;
+	uint32_t kind;
+	uint64_t count;
+	/* Base of the bin of placements, 0 for items. */
+	int32_t baseWidth;
+	int32_t baseDepth;
+	uint8_t reserved[32];
+
+	static const uint32_t byteOrderMark = 0x01020304;
+	static const uint32_t currentVersion = 1;
+	static const size_t columnAlignment = 64;
+};
+
+/**
+ * Binary columnar file of cuboids, mapped into memory. Columns are used in
+ * place: opening checks only the header and the size of the file, so the
+ * time of loading is the time of reading pages of the file.
+ */
+class ColumnarFile {
+public:
+	enum Kind
+	{
+		KindItems = 1,
+		KindPlacements = 2
+	};
+
+	ColumnarFile() : header(0) {}
+
+	/* @return false if the file can not be read or is not a valid columnar
+	 * file of this version, see getError(). */
+	bool open(const char* filename);
+
+	Kind kind() const { return Kind(header->kind); }
+	size_t size() const { return header->count; }
+	Rect base() const { return Rect(header->baseWidth, header->baseDepth); }
+
+	/* Columns of items. */
+	const float* widths() const { return column<float>(0); }
+	const float* heights() const { return column<float>(1); }
+	const float* depths() const { return column<float>(2); }
+
+	/* Columns of placements. */
+	const uint32_t* ids() const { return column<uint32_t>(0); }
+	const uint8_t* orientations() const { return column<uint8_t>(1); }
+	const uint32_t* containers() const { return column<uint32_t>(2); }
+	const float* xs() const { return column<float>(3); }
+	const float* ys() const { return column<float>(4); }
+	const float* zs() const { return column<float>(5); }
+
+	/* Append cuboids of items, the id of a cuboid is its position. */
+	void loadItems(std::vector<Cuboid>& cuboids) const;
+
+	/* Append placed cuboids, sized by the input cuboids with their ids.
+	 * @return false if an id is not of an input cuboid or an orientation is
+	 * not a row of itemOrientations, see getError(); nothing is appended. */
+	bool loadPlacements(const std::vector<Cuboid>& inputs,
+			std::vector<Cuboid>& placed);
+
+	const std::string& getError() const { return error; }
+
+	/* Offset of a column in a file of the kind with count values. */
+	static size_t columnOffset(Kind kind, size_t count, int column);
+
+	/* Size of a file of the kind with count values. */
+	static size_t fileSize(Kind kind, size_t count);
+
+private:
+	MappedFile file;
+	const ColumnarHeader* header;
+	std::string error;
+
+	template <class T>
+	const T* column(int index) const
+	{
+		return reinterpret_cast<const T*>(file.data() +
+				columnOffset(kind(), size(), index));
+	}
+};
+
+/* Save input cuboids as a columnar file of items.
+ * @return false if the file can not be written. */
+bool saveItemsColumnar(const std::vector<Cuboid>& cuboids,
+		const char* filename);
+
+/* Save placed cuboids, positioned by the corner with the lowest
+ * coordinates, as a columnar file of placements. Orientations are found
+ * by comparing sizes with the input cuboids of the same ids.
+ * @return false if the file can not be written, or if a placed cuboid has
+ * no input cuboid of its id or of its sizes in some orientation; the file
+ * is not written then. The reason is stored in error if it is given. */
+bool savePlacementsColumnar(const std::vector<Cuboid>& placed,
+		const std::vector<Cuboid>& inputs, const Rect& base,
+		const char* filename, std::string* error = 0);
+
+#endif /* COLUMNAR_FILE_HPP_ */
@@ -0,0 +1,86 @@
+//============================================================================
+// Name        : container_packer.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef CONTAINER_PACKER_HPP_
+#define CONTAINER_PACKER_HPP_
+
+#include <deque>
+#include <vector>
+
+#include "cuboid.hpp"
+#include "placement_sink.hpp"
+#include "shelf_algorithm.hpp"
+#include "shelf_capacity_index.hpp"
+
+/**
+ * Packs cuboids into containers of a finite height, opening a new container
+ * when no open one can hold a cuboid. Every container is packed by its own
+ * ShelfAlgorithm.
+ *
+ * Open containers are leaves of a ShelfCapacityIndex, two leaves for every
+ * container: the summary of its shelves and the summary of a new shelf on
+ * top of the last one. A container is tried only if one of its leaves may
+ * hold the cuboid, so full lower containers are skipped in O(log containers).
+ * Containers which pass the summary but do not hold the cuboid are tried one
+ * by one, so the worst case is O(containers) tries, each with a search of
+ * the index.
+ */
+class ContainerPacker {
+public:
+	ContainerPacker(float width, float depth, float height);
+
+	/* Insert a cuboid into the first container which holds it, opening a new
+	 * container if there is none. The returned cuboid is placed in the
+	 * container with index container, unless it is higher than the
+	 * container or its base is larger. */
+	Cuboid insert(const Cuboid& cuboid,
+			ShelfAlgorithm::ShelfChoiceHeuristic method);
+
+	/* Insert cuboids in the given order.
+	 * @return Number of cuboids not placed. */
+	size_t insert(const std::vector<Cuboid>& cuboids,
+			ShelfAlgorithm::ShelfChoiceHeuristic method);
+
+	/* Merge free rectangles of shelves of new containers, see
+	 * ShelfAlgorithm::setMergeEnabled(). */
+	void setMergeEnabled(bool enabled) { mergeEnabled = enabled; }
+
+	/* Pass every placed cuboid, with its container, to the sink as soon as
+	 * it is placed (none by default). */
+	void setPlacementSink(PlacementSink* sink) { placementSink = sink; }
+
+	/* Placed cuboids of all containers, y is measured from the floor of the
+	 * container of the cuboid. */
+	const std::vector<Cuboid>& getUsedCuboids() const { return usedCuboids; }
+
+	size_t getContainerCount() const { return containers.size(); }
+
+	/* Number of merges of free rectangles in all containers. */
+	unsigned long getMergeCount() const;
+
+private:
+	float width;
+	float depth;
+	float height;
+	bool mergeEnabled;
+
+	/* A deque keeps containers in place when a new one is opened. */
+	std::deque<ShelfAlgorithm> containers;
+	ShelfCapacityIndex containerIndex;
+
+	std::vector<Cuboid> usedCuboids;
+	PlacementSink* placementSink;
+
+	/* Summary of an empty container. */
+	ShelfCapacityIndex::Capacity emptyContainer;
+
+	void openContainer();
+
+	/* Update both leaves of a container after an insertion. */
+	void updateIndex(size_t container);
+};
+
+#endif /* CONTAINER_PACKER_HPP_ */
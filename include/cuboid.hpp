@@ -6,16 +6,35 @@
 #ifndef CUBOID_HPP
 #define CUBOID_HPP
 
+#include <algorithm>
+#include <limits>
 #include <vector>
 #include <boost/serialization/nvp.hpp>
+#include <boost/serialization/version.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 
-class Cuboid {
+/**
+ * Cuboid with coordinates of type T, as read from and written to xml files.
+ * Cuboid (float) is used by the shelf algorithm and for input and output of
+ * all algorithms. The guillotine algorithm packs items (see item.hpp) and
+ * keeps its free space as free cuboids (see free_cuboid.hpp).
+ */
+template <class T>
+class BasicCuboid {
 public:
-	Cuboid() {}
-    Cuboid(float w, float h, float d) :
+	typedef T Coordinate;
+
+	BasicCuboid() {}
+    BasicCuboid(T w, T h, T d) :
         width(w), height(h), depth(d) {}
 
+    /* Convert a cuboid with other coordinates. */
+    template <class U>
+    explicit BasicCuboid(const BasicCuboid<U>& other) :
+        width(other.width), height(other.height), depth(other.depth),
+        x(other.x), y(other.y), z(other.z), isPlaced(other.isPlaced),
+        id(other.id), container(other.container) {}
+
     template<class Archive>
     void serialize(Archive &ar, const unsigned int file_verision)
     {
@@ -25,36 +44,48 @@ public:
         ar & boost::serialization::make_nvp("x", x);
         ar & boost::serialization::make_nvp("y", y);
         ar & boost::serialization::make_nvp("z", z);
+        // Files written before ids were added have version 0.
+        if (file_verision >= 1)
+            ar & boost::serialization::make_nvp("id", id);
+        if (file_verision >= 2)
+            ar & boost::serialization::make_nvp("container", container);
     }
 
-    float width;
-    float height;
-    float depth;
-    float x = 0;
-    float y = 0;
-    float z = 0;
+    T width;
+    T height;
+    T depth;
+    T x = 0;
+    T y = 0;
+    T z = 0;
     bool isPlaced = false;
 
-    /* Variable useful in global guillotine algorithm to store a score
-     * of choosing this cuboid. */
-    float score = std::numeric_limits<float>::max();
+    /* Position of the cuboid in the input, kept by its placement. */
+    unsigned id = 0;
+
+    /* Index of the container holding the placed cuboid, see
+     * ContainerPacker. */
+    unsigned container = 0;
 
-    static bool compareMaxEdge(Cuboid i,Cuboid j)
+    static bool compareMaxEdge(BasicCuboid i, BasicCuboid j)
     {
-    	float i_max = std::max({i.width, i.height, i.depth});
-    	float j_max = std::max({j.width, j.height, j.depth});
+    	T i_max = std::max({i.width, i.height, i.depth});
+    	T j_max = std::max({j.width, j.height, j.depth});
     	return i_max > j_max;
     }
 
-    static bool compareVolume(Cuboid i,Cuboid j)
+    static bool compareVolume(BasicCuboid i, BasicCuboid j)
     {
     	return ((i.width * i.height * i.depth) > (j.width * j.height * j.depth));
     }
 
-    friend bool operator<(const Cuboid& lhs,const Cuboid& rhs){
+    friend bool operator<(const BasicCuboid& lhs,const BasicCuboid& rhs){
         return (lhs.width * lhs.height * lhs.depth) < (rhs.width * rhs.depth * rhs.height);
     }
 
 };
 
+typedef BasicCuboid<float> Cuboid;
+
+BOOST_CLASS_VERSION(Cuboid, 2)
+
 #endif
@@ -0,0 +1,77 @@
+//============================================================================
+// Name        : cuboid_io.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef CUBOID_IO_HPP_
+#define CUBOID_IO_HPP_
+
+#include <vector>
+
+#include "cuboid.hpp"
+#include "rect.hpp"
+
+/* Save cuboids, and the base of the bin unless it is empty, as an xml
+ * archive. */
+void saveXml(const std::vector<Cuboid>& cuboids, const Rect& base,
+		const char* filename);
+
+/* Load cuboids of an xml file with CuboidXmlParser, the id of a cuboid is
+ * its position. Throws std::runtime_error if the file can not be read or is
+ * malformed. */
+std::vector<Cuboid> loadCuboidsFromXml(const char* filename);
+
+/* Load cuboids of an xml file with a Boost xml archive, the same as
+ * loadCuboidsFromXml() but slower. */
+std::vector<Cuboid> loadCuboidsFromXmlArchive(const char* filename);
+
+/* Generate random cuboids, the parameter is the number of equal edges
+ * (1 - every edge is different). */
+std::vector<Cuboid> generateRandomCuboids(int number, int parameter);
+
+/* Check if a file name has the extension of columnar files (.bpc), see
+ * ColumnarFile. Other files are xml files. */
+bool isColumnarFile(const char* filename);
+
+/* Load input cuboids of an xml, a columnar, a CSV or a JSON lines file, by
+ * the extension (see CuboidTextParser). Text files are parsed on the given
+ * number of threads, the number of hardware threads if 0. Throws
+ * std::runtime_error if the file can not be read or is malformed. */
+std::vector<Cuboid> loadCuboids(const char* filename, unsigned threads = 0);
+
+/* Save input cuboids to an xml or a columnar file, by the extension. */
+void saveCuboids(const std::vector<Cuboid>& cuboids, const char* filename);
+
+/* Load placed cuboids of a columnar file of placements, positioned by the
+ * corner with the lowest coordinates and sized by the input cuboids with
+ * their ids; the base of the bin is stored in base. Throws
+ * std::runtime_error if the file can not be read, is not a file of
+ * placements or does not match the input cuboids. */
+std::vector<Cuboid> loadPlacedCuboids(const char* filename,
+		const std::vector<Cuboid>& inputs, Rect& base);
+
+/* Save placed cuboids, positioned by the corner with the lowest coordinates,
+ * to an xml file (transformed, with the base) or to a columnar file of
+ * placements, by the extension. Ids of placed cuboids are positions of the
+ * input cuboids. Throws std::runtime_error if the file can not be written
+ * or a placed cuboid does not match the input cuboid of its id. */
+void savePlacedCuboids(const std::vector<Cuboid>& placed,
+		const std::vector<Cuboid>& inputs, const Rect& base,
+		const char* filename);
+
+/* Save placed cuboids, positioned by the corner with the lowest coordinates,
+ * for the viewer (visual/app/cuboids.html): little-endian float32 values,
+ * the width and the depth of the base followed by x, y, z of the center and
+ * width, height, depth of every cuboid. Containers of the given height are
+ * stacked: a cuboid of container i is drawn i * containerHeight higher.
+ * Throws std::runtime_error if the file can not be written. */
+void saveRenderBuffer(const std::vector<Cuboid>& placed, const Rect& base,
+		const char* filename, float containerHeight = 0);
+
+/* Move coordinates of placed cuboids from the corner with the lowest
+ * coordinates to the center, as displayed by Three.js. */
+std::vector<Cuboid> transform(const std::vector<Cuboid>& cuboids);
+Cuboid transform(const Cuboid& cuboid);
+
+#endif /* CUBOID_IO_HPP_ */
@@ -0,0 +1,114 @@
+//============================================================================
+// Name        : cuboid_text_parser.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef CUBOID_TEXT_PARSER_HPP_
+#define CUBOID_TEXT_PARSER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "cuboid.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * Parser of cuboids exported as text, one cuboid per line:
+ *  - CSV: fields separated by commas. Double quotes around a field are
+ *    removed, but a quoted field can not hold a comma. If the first line is
+ *    a header (its first field is not a number), the columns named width,
+ *    height and depth are read and others are skipped; otherwise the first
+ *    three columns are width, height and depth.
+ *  - JSON lines: an object per line with numbers width, height and depth;
+ *    other members are skipped.
+ * Blank lines are skipped. Sizes have to be finite and positive, a line
+ * with another size is malformed.
+ *
+ * The file is mapped into memory and split into chunks at line boundaries,
+ * which are parsed on threads: lines of every chunk are counted first, so
+ * cuboids are written in place into an output allocated once, in the order
+ * of the file. The id of a cuboid is its position, the same as of
+ * loadCuboidsFromXml(). Errors are reported by return values with the line
+ * of the error; the first malformed line of the file is reported.
+ */
+class CuboidTextParser {
+public:
+	enum Format
+	{
+		FormatCsv, // .csv
+		FormatJsonLines // .jsonl, .ndjson
+	};
+
+	CuboidTextParser();
+
+	/* Format of a file by its extension.
+	 * @return false if the extension is not of a text format. */
+	static bool formatOf(const char* filename, Format* format);
+
+	/* Map the file. @return false if it can not be read. */
+	bool open(const char* filename);
+	void close();
+
+	/* Size of the file in bytes. */
+	size_t size() const { return length; }
+
+	/**
+	 * Parse cuboids on the given number of threads (the number of hardware
+	 * threads if 0) and append them to the vector.
+	 * @return false if a line is malformed, see getError().
+	 */
+	bool parse(Format format, std::vector<Cuboid>& cuboids,
+			unsigned threads = 0);
+
+	/* Description of the last error, with its line. */
+	const std::string& getError() const { return error; }
+
+private:
+	MappedFile file;
+	const char* data;
+	size_t length;
+	std::string error;
+
+	/* Columns of a CSV file, -1 for a column which is not there. */
+	struct Columns
+	{
+		int width;
+		int height;
+		int depth;
+	};
+
+	/* Part of the file from a line boundary to another one. */
+	struct Chunk
+	{
+		const char* begin;
+		const char* end;
+		/* Line of begin, counted from 1. */
+		size_t firstLine;
+		size_t lines;
+		/* Non blank lines, one cuboid each. */
+		size_t records;
+		/* Position of the first cuboid of the chunk in the file. */
+		size_t first;
+		/* First malformed line, 0 if there is none. */
+		size_t errorLine;
+		const char* errorMessage;
+	};
+
+	/* Read the header of a CSV file, if there is one, and move begin past
+	 * it. @return false if the header lacks a column. */
+	bool readCsvHeader(const char*& begin, size_t& line, Columns& columns);
+
+	static void countLines(Chunk& chunk);
+
+	static void parseChunk(Chunk& chunk, Format format,
+			const Columns& columns, Cuboid* out);
+
+	static const char* parseCsvLine(const char* begin, const char* end,
+			const Columns& columns, Cuboid& cuboid);
+
+	static const char* parseJsonLine(const char* begin, const char* end,
+			Cuboid& cuboid);
+};
+
+#endif /* CUBOID_TEXT_PARSER_HPP_ */
@@ -0,0 +1,86 @@
+//============================================================================
+// Name        : cuboid_xml_parser.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef CUBOID_XML_PARSER_HPP_
+#define CUBOID_XML_PARSER_HPP_
+
+#include <string>
+#include <vector>
+
+#include "cuboid.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * Parser of xml files of cuboids, as written by saveXml(): <cuboid> elements
+ * with width, height, depth, x, y and z, and optionally id and container.
+ * Other elements (the header and the base) are skipped.
+ *
+ * The file is mapped into memory and parsed in place, numbers are read with
+ * std::from_chars, so parsing allocates only the output. Errors are
+ * reported by return values with the line of the error, not by exceptions.
+ * The id of a parsed cuboid is its position in the file, the same as of
+ * loadCuboidsFromXml().
+ */
+class CuboidXmlParser {
+public:
+	CuboidXmlParser();
+
+	/* Map the file. @return false if it can not be read. */
+	bool open(const char* filename);
+	void close();
+
+	/* Size of the file in bytes. */
+	size_t size() const { return length; }
+
+	/* Number of <cuboid> elements, used to reserve the output. */
+	size_t countCuboids() const;
+
+	/**
+	 * Parse cuboids and pass them to the sink one by one, as
+	 * sink(const Cuboid&).
+	 * @return false if the file is malformed, see getError().
+	 */
+	template <class Sink>
+	bool parse(Sink sink);
+
+	/* Parse cuboids and append them to the vector, reserved first. */
+	bool parse(std::vector<Cuboid>& cuboids);
+
+	/* Description of the last error, with its line. */
+	const std::string& getError() const { return error; }
+
+private:
+	MappedFile file;
+	const char* data;
+	size_t length;
+	std::string error;
+
+	/* Start of the next <cuboid> element at or after p, or the end. */
+	const char* findCuboid(const char* p) const;
+
+	/* Parse the element starting at p, which is moved past its end. */
+	bool parseCuboid(const char*& p, Cuboid& cuboid);
+
+	bool fail(const char* at, const char* message);
+};
+
+template <class Sink>
+bool CuboidXmlParser::parse(Sink sink)
+{
+	const char* end = data + length;
+	unsigned id = 0;
+	for (const char* p = findCuboid(data); p != end; p = findCuboid(p))
+	{
+		Cuboid cuboid;
+		if (!parseCuboid(p, cuboid))
+			return false;
+		cuboid.id = id++;
+		sink(static_cast<const Cuboid&>(cuboid));
+	}
+	return true;
+}
+
+#endif /* CUBOID_XML_PARSER_HPP_ */
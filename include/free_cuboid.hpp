@@ -0,0 +1,34 @@
+//============================================================================
+// Name        : free_cuboid.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef FREE_CUBOID_HPP_
+#define FREE_CUBOID_HPP_
+
+#include <limits>
+
+/**
+ * Free space of a guillotine bin with coordinates of type T.
+ */
+template <class T>
+struct BasicFreeCuboid
+{
+	T x = 0;
+	T y = 0;
+	T z = 0;
+	T width = 0;
+	T height = 0;
+	T depth = 0;
+
+	/* Free cuboid which reaches the top of a bin without a height limit.
+	 * Its height is unboundedHeight(), so every cuboid fits its height. */
+	bool unbounded = false;
+
+	static T unboundedHeight() { return std::numeric_limits<T>::max(); }
+};
+
+typedef BasicFreeCuboid<float> FreeCuboid;
+
+#endif /* FREE_CUBOID_HPP_ */
@@ -0,0 +1,73 @@
+//============================================================================
+// Name        : free_cuboid_faces.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef FREE_CUBOID_FACES_HPP_
+#define FREE_CUBOID_FACES_HPP_
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+
+#include "free_cuboid.hpp"
+
+/**
+ * Faces of free cuboids of Guillotine3d, used to find two free cuboids which
+ * share a full face and can be merged into one.
+ *
+ * For every axis a free cuboid has a low face (at its minimal coordinate)
+ * and a high face (at its maximal coordinate). Two free cuboids share a full
+ * face if a high face of one of them is the low face of the other one.
+ * Free cuboids of a guillotine bin are disjoint, so every face belongs to at
+ * most one free cuboid. Coordinates are of type T.
+ */
+template <class T>
+class BasicFreeCuboidFaces {
+public:
+	void clear();
+
+	void insert(const BasicFreeCuboid<T>& freeCuboid, unsigned slot);
+
+	void erase(const BasicFreeCuboid<T>& freeCuboid);
+
+	/* Update the slot of a free cuboid which was moved. */
+	void setSlot(const BasicFreeCuboid<T>& freeCuboid, unsigned slot);
+
+	/**
+	 * Find a free cuboid sharing a full face with the given one.
+	 * @return true if such free cuboid exists, its slot is stored in slot.
+	 */
+	bool findNeighbour(const BasicFreeCuboid<T>& freeCuboid,
+			unsigned* slot) const;
+
+private:
+	/* Axis, coordinate of the face along the axis, and position and size of
+	 * the face along the two other axes. */
+	typedef std::array<T, 6> FaceKey;
+
+	struct FaceKeyHash
+	{
+		size_t operator()(const FaceKey& key) const
+		{
+			size_t hash = 0;
+			for (T value : key)
+				hash = hash * 1000003 ^ std::hash<T>()(value);
+			return hash;
+		}
+	};
+
+	typedef std::unordered_map<FaceKey, unsigned, FaceKeyHash> FaceMap;
+
+	FaceMap lowFaces;
+	FaceMap highFaces;
+
+	static FaceKey lowFace(const BasicFreeCuboid<T>& c, int axis);
+	static FaceKey highFace(const BasicFreeCuboid<T>& c, int axis);
+};
+
+typedef BasicFreeCuboidFaces<float> FreeCuboidFaces;
+
+#endif /* FREE_CUBOID_FACES_HPP_ */
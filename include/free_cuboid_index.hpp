@@ -0,0 +1,111 @@
+//============================================================================
+// Name        : free_cuboid_index.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef FREE_CUBOID_INDEX_HPP_
+#define FREE_CUBOID_INDEX_HPP_
+
+#include <algorithm>
+#include <vector>
+
+#include "free_cuboid.hpp"
+#include "item.hpp"
+
+/**
+ * Index over the free cuboids of Guillotine3d ordered by their y coordinate.
+ *
+ * Free cuboids are grouped into buckets with the same y. Buckets are kept in
+ * a flat array sorted by y and every bucket stores the maximal shortest,
+ * middle and longest edge of its free cuboids. A bucket in which a cuboid can
+ * not fit in any orientation is skipped without looking at its free cuboids.
+ *
+ * Every free cuboid is identified by a sequence number, which grows with
+ * the order in which free cuboids are added, and remembers its slot in
+ * Guillotine3d::freeCuboids. Coordinates are of type T.
+ */
+template <class T>
+class BasicFreeCuboidIndex {
+public:
+	void clear();
+
+	void insert(const BasicFreeCuboid<T>& freeCuboid, unsigned long seq,
+			unsigned slot);
+
+	/* Remove a free cuboid. Unlike BasicFreeCuboidStore::erase() this is not
+	 * O(1): entries of the bucket stay sorted by sequence number and its
+	 * summary is recomputed, which is O(bucket size), and removing an empty
+	 * bucket is O(buckets). */
+	void erase(const BasicFreeCuboid<T>& freeCuboid, unsigned long seq);
+
+	/* Update the slot of a free cuboid which was moved. */
+	void setSlot(const BasicFreeCuboid<T>& freeCuboid, unsigned long seq,
+			unsigned slot);
+
+	/**
+	 * Find a free cuboid with the lowest y + item.height, in which the given
+	 * item fits in any orientation. Ties are resolved by the lowest sequence
+	 * number, the same as the linear scan over free cuboids does.
+	 * @return true if such free cuboid exists, its slot is stored in slot.
+	 */
+	bool findMinHeight(const BasicItem<T>& item, unsigned* slot) const;
+
+private:
+	/* Edges of a cuboid sorted in increasing order. */
+	struct Edges
+	{
+		T e[3];
+
+		Edges() {}
+		Edges(T width, T height, T depth);
+		explicit Edges(const T sorted[3])
+		{
+			std::copy(sorted, sorted + 3, e);
+		}
+
+		/* Check if a cuboid with these edges fits in some orientation into
+		 * a space with the given edges. */
+		bool fitsInto(const Edges& space) const
+		{
+			return e[0] <= space.e[0] && e[1] <= space.e[1] &&
+					e[2] <= space.e[2];
+		}
+	};
+
+	struct Entry
+	{
+		unsigned long seq;
+		unsigned slot;
+		Edges edges;
+	};
+
+	struct Bucket
+	{
+		T y;
+		/* Maximal sorted edges of free cuboids in the bucket. */
+		Edges maxEdges;
+		/* Index into entries. */
+		unsigned slot;
+	};
+
+	/* Buckets sorted by y. */
+	std::vector<Bucket> buckets;
+
+	/* Entries of buckets, sorted by sequence number. Unused slots are reused
+	 * by new buckets. */
+	std::vector<std::vector<Entry> > entries;
+	std::vector<unsigned> freeSlots;
+
+	typename std::vector<Bucket>::iterator findBucket(T y);
+
+	typename std::vector<Entry>::iterator findEntry(
+			const BasicFreeCuboid<T>& freeCuboid, unsigned long seq,
+			typename std::vector<Bucket>::iterator* bucket);
+
+	void updateSummary(Bucket& bucket);
+};
+
+typedef BasicFreeCuboidIndex<float> FreeCuboidIndex;
+
+#endif /* FREE_CUBOID_INDEX_HPP_ */
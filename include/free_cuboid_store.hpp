@@ -0,0 +1,106 @@
+//============================================================================
+// Name        : free_cuboid_store.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef FREE_CUBOID_STORE_HPP_
+#define FREE_CUBOID_STORE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "free_cuboid.hpp"
+
+/**
+ * Fit kernels, shared by free cuboid stores of all coordinate types.
+ */
+class FreeCuboidStoreBase {
+public:
+	/* Implementations of the fit test. */
+	enum FitKernel
+	{
+		FitKernelScalar,
+		FitKernelSse,
+		FitKernelAvx2
+	};
+
+	/* Number of free cuboids tested in one fitMasks() call. */
+	static constexpr size_t maskBlock = 64;
+
+	static bool isFitKernelSupported(FitKernel fitKernel);
+
+	/* The fastest kernel supported by the CPU. */
+	static FitKernel bestFitKernel();
+
+	static const char* fitKernelName(FitKernel fitKernel);
+};
+
+/**
+ * Free cuboids of Guillotine3d stored as a structure of arrays: positions
+ * and sizes are kept in separate arrays, so the fit test reads only the
+ * sizes of free cuboids. Coordinates are of type T (float, int32_t or
+ * int16_t); integer sizes are compared with integer vector instructions and
+ * int16_t packs twice as many free cuboids into a vector.
+ *
+ * Every free cuboid has a sequence number given when it was added. Removal
+ * moves the last free cuboid into the freed slot, so the order of slots is
+ * not the order of sequence numbers.
+ */
+template <class T>
+class BasicFreeCuboidStore : public FreeCuboidStoreBase {
+public:
+	BasicFreeCuboidStore() : kernel(bestFitKernel()) {}
+
+	size_t size() const { return x.size(); }
+	bool empty() const { return x.empty(); }
+
+	void clear();
+	void push_back(const BasicFreeCuboid<T>& freeCuboid, unsigned long seq);
+
+	/* Remove a free cuboid in O(1). If index was not the last slot, the last
+	 * free cuboid is moved into it. */
+	void erase(size_t index);
+
+	/* Undo erase(index): the free cuboid in index is moved to the end and
+	 * the given one is put into index. */
+	void insert(size_t index, const BasicFreeCuboid<T>& freeCuboid,
+			unsigned long seq);
+
+	void pop_back();
+
+	BasicFreeCuboid<T> operator[](size_t index) const;
+
+	unsigned long getSeq(size_t index) const { return seq[index]; }
+
+	/**
+	 * Test in which orientations a cuboid fits into free cuboids
+	 * [first, first + count), where count <= maskBlock.
+	 * Bit i of masks[o] is set, if the cuboid rotated by itemOrientations[o]
+	 * fits into the free cuboid first + i.
+	 */
+	void fitMasks(size_t first, size_t count,
+			T width, T height, T depth, uint64_t masks[6]) const;
+
+	/* Select the implementation of fitMasks(). All of them give the same
+	 * results. Returns false if the kernel is not supported by the CPU. */
+	bool setFitKernel(FitKernel fitKernel);
+	FitKernel getFitKernel() const { return kernel; }
+
+private:
+	std::vector<T> x;
+	std::vector<T> y;
+	std::vector<T> z;
+	std::vector<T> width;
+	std::vector<T> height;
+	std::vector<T> depth;
+	std::vector<unsigned long> seq;
+	std::vector<uint8_t> unbounded;
+
+	FitKernel kernel;
+};
+
+typedef BasicFreeCuboidStore<float> FreeCuboidStore;
+
+#endif /* FREE_CUBOID_STORE_HPP_ */
@@ -0,0 +1,195 @@
+//============================================================================
+// Name        : global_search.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef GLOBAL_SEARCH_HPP_
+#define GLOBAL_SEARCH_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "guillotine3d.hpp"
+#include "item.hpp"
+
+/**
+ * Search for the order of inserting cuboids into Guillotine3d, which gives
+ * the lowest filled bin height.
+ *
+ * Orders are built item by item in one bin: an item is inserted, the
+ * orders starting with it are searched and the insert is undone with
+ * Guillotine3d::rollback(), so orders with a shared prefix do not repack it.
+ * The height of a partial order never
+ * decreases, so a partial order is dropped as soon as its height, or a lower
+ * bound of the final height, is not better than the best complete order.
+ * The lower bound is the larger of:
+ *  - the highest minimal vertical edge of a cuboid (over the orientations
+ *    which fit the base; the longest edge has to stand if it does not fit
+ *    the base),
+ *  - the total volume of cuboids divided by the base area.
+ *
+ * Branch and bound may run on several threads. The orders are split into
+ * tasks by their first two cuboids, which workers take in the depth first
+ * order. The best height found so far is shared through an atomic together
+ * with the number of its task, so a tie is won by the earlier task and the
+ * result is the same as the one of the single threaded search.
+ *
+ * Coordinates are of type T, the same as of the searched bins. Heights and
+ * the lower bound are compared in T too, so float heights which differ by
+ * less than 1 are not ties.
+ */
+template <class T>
+class BasicGlobalSearch {
+public:
+	/* Every searched bin is a copy of emptyBin, so it keeps its settings
+	 * (e.g. compaction). */
+	BasicGlobalSearch(const BasicGuillotine3d<T>& emptyBin,
+			Guillotine3dBase::FreeCuboidChoiceHeuristic cuboidChoice,
+			Guillotine3dBase::GuillotineSplitHeuristic splitMethod);
+
+	/**
+	 * Exact branch and bound over all orders, run on the given number of
+	 * threads. If nodeLimit is not 0, the search stops after visiting about
+	 * nodeLimit partial orders and returns the best order found so far,
+	 * which is never worse than inserting cuboids sorted by the longest
+	 * edge.
+	 * @return Bin with the best order of cuboids inserted.
+	 */
+	BasicGuillotine3d<T> branchAndBound(
+			const std::vector<BasicItem<T> >& cuboids,
+			unsigned long nodeLimit = 0, unsigned threads = 1);
+
+	/**
+	 * Beam search: for every length of a partial order only beamWidth partial
+	 * orders with the least wasted volume are extended, each with one of the
+	 * next beamWindow remaining cuboids (sorted by the longest edge). The
+	 * result is never worse than inserting cuboids sorted by the longest
+	 * edge.
+	 * @return Bin with the best order of cuboids inserted.
+	 */
+	BasicGuillotine3d<T> beamSearch(
+			const std::vector<BasicItem<T> >& cuboids,
+			unsigned beamWidth);
+
+	/* Lower bound of the bin height of the last search. */
+	T getLowerBound() const { return lowerBound; }
+
+	/* Number of partial orders visited by the last search. */
+	unsigned long getVisitedNodes() const { return visitedNodes; }
+
+	/* True if the result of the last search is proven to be optimal. */
+	bool isOptimal() const { return optimal; }
+
+	/* Number of remaining cuboids tried as the next one in beam search. */
+	static const unsigned beamWindow = 2;
+
+private:
+	BasicGuillotine3d<T> emptyBin;
+	int binWidth;
+	int binDepth;
+	Guillotine3dBase::FreeCuboidChoiceHeuristic cuboidChoice;
+	Guillotine3dBase::GuillotineSplitHeuristic splitMethod;
+
+	T lowerBound;
+	unsigned long visitedNodes;
+	unsigned long nodeLimit;
+	bool optimal;
+
+	/* Items sorted by the longest edge, so the first complete order is the
+	 * one used by the guillotine algorithm. */
+	std::vector<BasicItem<T> > items;
+	/* Index of the previous item with the same size or -1, used to skip
+	 * orders which differ only by swapping two equal cuboids. */
+	std::vector<int> previousEqual;
+
+	/* Branch and bound state of one thread. */
+	struct Worker
+	{
+		Worker(const BasicGuillotine3d<T>& emptyBin, size_t items);
+
+		/* Bin with the current partial order inserted. */
+		BasicGuillotine3d<T> bin;
+		typename BasicGuillotine3d<T>::Mark emptyMark;
+		std::vector<unsigned> order;
+		std::vector<bool> used;
+		unsigned long visited;
+		/* Visited nodes not yet added to sharedVisited. */
+		unsigned long unreported;
+		unsigned task;
+		uint64_t bestKey;
+		T bestHeight;
+		std::vector<unsigned> bestOrder;
+	};
+
+	/* First cuboids of orders searched by one task, in depth first order. */
+	std::vector<std::vector<unsigned> > tasks;
+	std::atomic<unsigned> nextTask;
+
+	/* Height of the best complete order in the upper 32 bits (see key()) and
+	 * its task in the lower ones. */
+	std::atomic<uint64_t> incumbent;
+
+	std::atomic<unsigned long> sharedVisited;
+	std::atomic<bool> aborted;
+
+	T bestHeight;
+	BasicGuillotine3d<T> best;
+
+	void prepare(const std::vector<BasicItem<T> >& cuboids);
+
+	T computeLowerBound() const;
+
+	/* Insert an item into a bin and return the new filled height. */
+	T insertItem(BasicGuillotine3d<T>& bin, unsigned item, T height) const;
+
+	/* Check if the item may be inserted next: an equal cuboid which is
+	 * earlier in items has to be inserted before it. */
+	bool canInsertNext(unsigned item, const std::vector<bool>& used) const
+	{
+		return !used[item] &&
+				(previousEqual[item] < 0 || used[previousEqual[item]]);
+	}
+
+	/* Heights are not negative, so the bits of a float height, as well as
+	 * an integer height, order keys the same way as the heights. */
+	static uint64_t key(T height, unsigned task)
+	{
+		uint32_t bits;
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			static_assert(sizeof(T) == sizeof(bits), "float heights");
+			std::memcpy(&bits, &height, sizeof(bits));
+		}
+		else
+			bits = uint32_t(height);
+		return (uint64_t(bits) << 32) | task;
+	}
+
+	/* Check if an order of the task with the given height could still
+	 * become the result. */
+	bool canBeat(T height, unsigned task) const
+	{
+		return key(height, task) < incumbent.load(std::memory_order_relaxed);
+	}
+
+	void generateTasks(unsigned taskLength, std::vector<unsigned>& prefix,
+			std::vector<bool>& used);
+
+	void runWorker(Worker& worker);
+
+	/* Count a visited node, return false if the node limit is reached. */
+	bool visitNode(Worker& worker);
+
+	void branch(Worker& worker, unsigned length, T height);
+
+	/* Insert items in the given order into a copy of emptyBin. */
+	BasicGuillotine3d<T> replay(const std::vector<unsigned>& order) const;
+};
+
+typedef BasicGlobalSearch<float> GlobalSearch;
+
+#endif /* GLOBAL_SEARCH_HPP_ */
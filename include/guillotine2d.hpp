@@ -7,6 +7,7 @@
 #ifndef GUILLOTINE2D_HPP_
 #define GUILLOTINE2D_HPP_
 
+#include <memory_resource>
 #include <vector>
 
 #include "rect.hpp"
@@ -18,7 +19,13 @@ class Guillotine2d {
 public:
 	/* Set the initial bin size to (0, 0).
 	 * Calls init() to set a proper bin size. */
-	Guillotine2d() : binWidth(0), binHeight(0) {}
+	Guillotine2d() : binWidth(0), binHeight(0), mergeEnabled(false),
+		mergeCount(0) {}
+
+	/* Rectangles are allocated from the given memory resource. */
+	explicit Guillotine2d(std::pmr::memory_resource* resource) :
+		binWidth(0), binHeight(0), usedRectangles(resource),
+		freeRectangles(resource), mergeEnabled(false), mergeCount(0) {}
 
 	/* Initialize a new bin */
 	Guillotine2d(int width, int height);
@@ -26,6 +33,8 @@ public:
 	/* Initialize an empty bin. */
 	void init(int width, int height);
 
+	/* Heuristics are implemented by policy types, see
+	 * guillotine_policies.hpp. */
 	enum FreeRectChoiceHeuristic
 		{
 			RectBestAreaFit,
@@ -40,48 +49,100 @@ public:
 		SplitLongerAxis
 	};
 
-	Rect insert(const Rect& rect, FreeRectChoiceHeuristic rectChoice,
-				GuillotineSplitHeuristic splitMethod);
+	/* Find the position of a rectangle, without taking it; isPlaced is
+	 * false if it does not fit. insertOnPosition() takes the position. */
+	Rect insert(const Rect& rect, FreeRectChoiceHeuristic rectChoice);
 
 	void insertOnPosition(const Rect& rect, GuillotineSplitHeuristic splitMethod);
 
+	/* Maximal number of rectangles given to insertFirstFitting(). */
+	static const int maxFirstFittingRects = 6;
+
+	/**
+	 * Insert the first of the given rectangles which fits the bin, in one
+	 * pass over free rectangles. The result is the same as of calling
+	 * insert() for the rectangles in turn and insertOnPosition() for the
+	 * first one placed.
+	 * @return Placed rectangle, isPlaced is false if none of the rectangles
+	 * fits. The index of the placed rectangle is stored in chosen.
+	 */
+	Rect insertFirstFitting(const Rect* rects, int count,
+			FreeRectChoiceHeuristic rectChoice,
+			GuillotineSplitHeuristic splitMethod, int* chosen);
+
 
-	std::vector<Rect>& getFreeRectangles() { return freeRectangles; }
+	/* Check if the rectangle fits a free rectangle, upright or sideways. */
+	bool canInsert(const Rect& rect) const;
 
-	std::vector<Rect>& getUsedRectangles() { return usedRectangles; }
+	std::pmr::vector<Rect>& getFreeRectangles() { return freeRectangles; }
+	const std::pmr::vector<Rect>& getFreeRectangles() const
+	{
+		return freeRectangles;
+	}
+
+	std::pmr::vector<Rect>& getUsedRectangles() { return usedRectangles; }
 
 	bool isEmpty() const { return usedRectangles.empty();}
 
+	/* Merge a new free rectangle with free rectangles sharing a full edge
+	 * with it (disabled by default). Placements differ from the ones without
+	 * merging. */
+	void setMergeEnabled(bool enabled) { mergeEnabled = enabled; }
+
+	/* Number of merges of two free rectangles into one since init(). */
+	unsigned long getMergeCount() const { return mergeCount; }
+
+	/* Free the storage of used and free rectangles of a bin which takes no
+	 * more rectangles. init() has to be called before inserting again. */
+	void release();
+
 private:
 	int binWidth;
 	int binHeight;
 
 	/* Stores rectangles that are packed so far */
-	std::vector<Rect> usedRectangles;
+	std::pmr::vector<Rect> usedRectangles;
 
 	/* Stores rectangles that represents the free area of the bin; */
-	std::vector<Rect> freeRectangles;
+	std::pmr::vector<Rect> freeRectangles;
 
-	/**
-	 * Search through all free rectangles to find the best one to place
-	 * a new rectangle.
-	 */
-	Rect findPositionForNewRect(const Rect& rect,
-			FreeRectChoiceHeuristic rectChoice) const;
+	bool mergeEnabled;
+	unsigned long mergeCount;
 
+	/* Add a non-degenerate free rectangle, merged with its neighbours if
+	 * merging is enabled. */
+	void addFreeRect(Rect freeRect);
 
+	/**
+	 * Merge b into a, if they share a full edge.
+	 * @return false if they do not share a full edge.
+	 */
+	static bool mergeFreeRects(Rect& a, const Rect& b);
 
-	static int scoreByHeuristic(const Rect& rect, const Rect &freeRect,
-								FreeRectChoiceHeuristic rectChoice);
-
-	static int scoreBestAreaFit(const Rect& rect, const Rect &freeRect);
-	static int scoreBestShortSideFit(const Rect& rect, const Rect &freeRect);
+	/**
+	 * Search through all free rectangles to find the best one to place
+	 * the first of the given rectangles which fits anywhere. Score is a
+	 * policy type, see guillotine_policies.hpp.
+	 * @return Position of the rectangle, its index is stored in chosen.
+	 */
+	template <class Score>
+	Rect findPositionForNewRect(const Rect* rects, int count,
+			int* chosen) const;
 
 	/* Splits the given L-shaped free rectangle into two new free rectangles
 	 * after placedRect has been placed into it. Determines the split axis by
-	 * using the given heuristic. */
-	void splitFreeRectByHeuristic(const Rect& freeRect, const Rect& placedRect,
-								  GuillotineSplitHeuristic method);
+	 * using the Split policy. */
+	template <class Split>
+	void splitFreeRectByHeuristic(const Rect& freeRect, const Rect& placedRect);
+
+	typedef Rect (Guillotine2d::*FindPositionFunction)(const Rect*, int,
+			int*) const;
+	typedef void (Guillotine2d::*SplitFunction)(const Rect&, const Rect&);
+
+	/* Instantiations of findPositionForNewRect and splitFreeRectByHeuristic
+	 * indexed by the heuristic enums. */
+	static const FindPositionFunction findPositionFunctions[];
+	static const SplitFunction splitFunctions[];
 
 	/* Splits the given L-shaped free rectangle into two new free rectangles
 	 * along the given fixed split axis. */
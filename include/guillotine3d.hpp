@@ -9,22 +9,27 @@
 
 #include <vector>
 
-#include "cuboid.hpp"
+#include "free_cuboid.hpp"
+#include "free_cuboid_faces.hpp"
+#include "free_cuboid_index.hpp"
+#include "free_cuboid_store.hpp"
+#include "item.hpp"
+#include "placement_sink.hpp"
 
 /**
- * 3D Guillotine bin packing - packing cuboids into a bin.
+ * Heuristics and statistics of the guillotine algorithm, shared by bins of
+ * all coordinate types.
  */
-class Guillotine3d {
+class Guillotine3dBase {
 public:
-	/* Initialize a new bin. Set the base area of cuboid. */
-	Guillotine3d(int width, int depth);
-
-	/* Initialize an empty bin. */
-	void init(int width, int depth);
-
+	/* Heuristics are implemented by policy types, see
+	 * guillotine_policies.hpp. */
 	enum FreeCuboidChoiceHeuristic
 		{
-			CuboidMinHeight
+			CuboidMinHeight,
+			CuboidBestVolumeFit,
+			CuboidBestShortSideFit,
+			CuboidContactArea
 		};
 
 	enum GuillotineSplitHeuristic
@@ -35,63 +40,227 @@ public:
 		SplitLongerAxis
 	};
 
+	struct CompactionStats
+	{
+		/* Free cuboids with zero width, height or depth not added. */
+		unsigned long degenerateDropped = 0;
+		/* Merges of two free cuboids into one. */
+		unsigned long merged = 0;
+	};
+};
+
+/**
+ * 3D Guillotine bin packing - packing items into a bin.
+ *
+ * Coordinates are of type T: float, or int32_t and int16_t for sizes on a
+ * whole grid. Integer coordinates are compared exactly and int16_t halves
+ * the memory of free cuboids; all coordinates of a packing, including the
+ * filled height, have to fit into T.
+ */
+template <class T>
+class BasicGuillotine3d : public Guillotine3dBase {
+public:
+	/* Initialize a new bin. Set the base area of cuboid. */
+	BasicGuillotine3d(int width, int depth);
+
+	/* Initialize an empty bin. */
+	void init(int width, int depth);
+
 	/**
-	 * Insert a cuboid with a given size.
-	 * @return Cuboid which has  cooridantes, where will be placed in a bin.
+	 * Insert an item.
+	 * @return false if the item does not fit the bin. Otherwise the
+	 * placement of the item is stored in placement, if it is not null.
 	 */
-	Cuboid insert(const Cuboid& cuboid, FreeCuboidChoiceHeuristic cuboidChoice,
-			GuillotineSplitHeuristic splitMethod);
+	bool insert(const BasicItem<T>& item,
+			FreeCuboidChoiceHeuristic cuboidChoice,
+			GuillotineSplitHeuristic splitMethod,
+			BasicPlacement<T>* placement = 0);
 
-	std::vector<Cuboid> insertVector(const std::vector<Cuboid>& cuboids,
+	/* Insert items in the given order. Cuboids taken by placed items, with
+	 * ids of the items, are passed to the sink as they are placed, if it is
+	 * not null. */
+	void insertVector(const std::vector<BasicItem<T> >& items,
 			FreeCuboidChoiceHeuristic cuboidChoice,
-			GuillotineSplitHeuristic splitMethod);
+			GuillotineSplitHeuristic splitMethod, PlacementSink* sink = 0);
 
-	void insertBestGlobal(std::vector<Cuboid> cuboids,
+	/**
+	 * Insert items in the order which gives the lowest bin height, found by
+	 * branch and bound (see GlobalSearch).
+	 */
+	void insertBestGlobal(std::vector<BasicItem<T> > items,
 			FreeCuboidChoiceHeuristic cuboidChoice,
 			GuillotineSplitHeuristic splitMethod);
 
-	std::vector<Cuboid>& getFreeCuboids() { return freeCuboids; }
+	/**
+	 * Insert items in the order found by beam search, keeping beamWidth
+	 * partial orders (see GlobalSearch).
+	 */
+	void insertBeamGlobal(std::vector<BasicItem<T> > items,
+			FreeCuboidChoiceHeuristic cuboidChoice,
+			GuillotineSplitHeuristic splitMethod, unsigned beamWidth);
+
+	const BasicFreeCuboidStore<T>& getFreeCuboids() const
+	{
+		return freeCuboids;
+	}
+
+	/* Placements of inserted items, in the order of inserts. */
+	const std::vector<BasicPlacement<T> >& getPlacements() const
+	{
+		return placements;
+	}
+
+	int getBinWidth() const { return binWidth; }
+	int getBinDepth() const { return binDepth; }
+
+	/* The highest top of a placed item, or -1 for an empty bin. */
+	T getFilledBinHeight() const { return filledHeight; }
 
-	std::vector<Cuboid>& getUsedCuboids() { return usedCuboids; }
 
-	int getFilledBinHeight();
+	/* Enable or disable searching free cuboids with the height ordered index
+	 * (enabled by default). Both ways give the same placements. */
+	void setHeightIndexEnabled(bool enabled) { heightIndexEnabled = enabled; }
+
+	/* Select the fit test used when scanning all free cuboids. Returns false
+	 * if the kernel is not supported by the CPU. */
+	bool setFitKernel(FreeCuboidStoreBase::FitKernel kernel)
+	{
+		return freeCuboids.setFitKernel(kernel);
+	}
+
+	/* Compaction of free cuboids: degenerate free cuboids are dropped and
+	 * free cuboids sharing a full face are merged. Placements differ from
+	 * the ones without compaction. Has to be set before inserting cuboids. */
+	void setCompactionEnabled(bool enabled);
+
+	const CompactionStats& getCompactionStats() const { return compactionStats; }
+
+	/* Number of free cuboids there would be without compaction. */
+	size_t getUncompactedFreeCuboidCount() const
+	{
+		return freeCuboids.size() + compactionStats.degenerateDropped +
+				compactionStats.merged;
+	}
+
+	/* State of the bin returned by mark(). */
+	struct Mark
+	{
+		size_t journal;
+		size_t placements;
+		T filledHeight;
+		unsigned long nextSeq;
+		CompactionStats compactionStats;
+	};
+
+	/**
+	 * Remember the current state of the bin. From now on every change of
+	 * free cuboids is recorded in a journal, so rollback() can undo the
+	 * inserts done after the mark without copying the bin.
+	 */
+	Mark mark();
+
+	/**
+	 * Undo all inserts done after the given mark. Marks taken later than
+	 * the given one become invalid. The bin is in the same state as it was
+	 * when the mark was taken, so following inserts give the same
+	 * placements.
+	 */
+	void rollback(const Mark& mark);
+
+	/* Invalidate all marks, clear the journal and stop recording changes. */
+	void discardMarks();
 
 private:
 	int binWidth;
 	int binHeight;
 	int binDepth;
 
-	/* Stores rectangles that are packed so far */
-	std::vector<Cuboid> usedCuboids;
+	bool heightIndexEnabled = true;
+	bool compactionEnabled = false;
+	CompactionStats compactionStats;
+
+	/* Stores items that are packed so far */
+	std::vector<BasicPlacement<T> > placements;
+	T filledHeight;
 
 	/* Stores rectangles that represents the free area of the bin; */
-	std::vector<Cuboid> freeCuboids;
+	BasicFreeCuboidStore<T> freeCuboids;
+
+	/* Sequence number of the next added free cuboid. */
+	unsigned long nextSeq;
+
+	/* Free cuboids ordered by y coordinate. */
+	BasicFreeCuboidIndex<T> freeCuboidIndex;
+
+	/* Faces of free cuboids, used only with compaction. */
+	BasicFreeCuboidFaces<T> freeCuboidFaces;
+
+	/* Change of free cuboids recorded for rollback(). */
+	struct JournalEntry
+	{
+		/* A free cuboid was added to the last slot, or removed from slot. */
+		bool added;
+		unsigned slot;
+		unsigned long seq;
+		BasicFreeCuboid<T> freeCuboid;
+	};
+
+	/* Enabled by mark() and disabled by init(). */
+	bool journalEnabled = false;
+	std::vector<JournalEntry> journal;
+
+	void addFreeCuboid(const BasicFreeCuboid<T>& freeCuboid);
+	void removeFreeCuboid(int index);
+
+	/* Bounding cuboid of two free cuboids sharing a full face. */
+	static BasicFreeCuboid<T> mergeFreeCuboids(const BasicFreeCuboid<T>& a,
+			const BasicFreeCuboid<T>& b);
 
 	/**
 	 * Search through all free rectangles to find the best one to place
-	 * a new rectangle.
+	 * a new item. Score is a policy type, see guillotine_policies.hpp.
+	 * @return false if the item fits nowhere. Otherwise the free cuboid
+	 * and the orientation (a row of itemOrientations) are stored in
+	 * nodeIndex and orientation.
 	 */
-	Cuboid findPositionForNewNode(const Cuboid& cuboid,
-			FreeCuboidChoiceHeuristic cuboidChoice,
-			int *nodeIndex) const;
+	template <class Score>
+	bool findPositionForNewNode(const BasicItem<T>& item, int* nodeIndex,
+			int* orientation) const;
 
-	static float scoreByHeuristic(const Cuboid& cuboid, const Cuboid& freeCuboid,
-			FreeCuboidChoiceHeuristic cuboidChoice);
+	/* Find the same position as findPositionForNewNode with CuboidMinHeight
+	 * heuristic, but only visit free cuboids which can beat the best one. */
+	bool findPositionMinHeightIndexed(const BasicItem<T>& item,
+			int* nodeIndex, int* orientation) const;
 
-	static float scoreMinHeight(const Cuboid& cuboid, const Cuboid& freeCuboid);
+	/* The first orientation in which the item fits into freeCuboid, in the
+	 * same order as findPositionForNewNode tries them, or -1. */
+	static int firstFittingOrientation(const BasicItem<T>& item,
+			const BasicFreeCuboid<T>& freeCuboid);
 
 	/* Splits the given L-shaped free rectangle into two new free rectangles
 	 * after placedCuboid has been placed into it. Determines the split axis by
-	 * using the given heuristic. */
-	void splitFreeCuboidByHeuristic(const Cuboid& freeCuboid,
-			const Cuboid& placedCuboid,
-			GuillotineSplitHeuristic method);
+	 * using the Split policy. */
+	template <class Split>
+	void splitFreeCuboidByHeuristic(const BasicFreeCuboid<T>& freeCuboid,
+			const BasicCuboid<T>& placedCuboid);
+
+	typedef bool (BasicGuillotine3d::*FindPositionFunction)(
+			const BasicItem<T>&, int*, int*) const;
+	typedef void (BasicGuillotine3d::*SplitFunction)(
+			const BasicFreeCuboid<T>&, const BasicCuboid<T>&);
+
+	/* Instantiations of findPositionForNewNode and splitFreeCuboidByHeuristic
+	 * indexed by the heuristic enums. */
+	static const FindPositionFunction findPositionFunctions[];
+	static const SplitFunction splitFunctions[];
 
 	/* Splits the given L-shaped free rectangle into two new free rectangles
 	 * along the given fixed split axis. */
-	void splitFreeCuboidAlongAxis(const Cuboid &freeCuboid,
-			const Cuboid &placedCuboid,
+	void splitFreeCuboidAlongAxis(const BasicFreeCuboid<T> &freeCuboid,
+			const BasicCuboid<T> &placedCuboid,
 			bool splitHorizontal);
 };
 
+typedef BasicGuillotine3d<float> Guillotine3d;
+
 #endif /* GUILLOTINE3D_HPP_ */
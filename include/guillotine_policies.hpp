@@ -0,0 +1,250 @@
+//============================================================================
+// Name        : guillotine_policies.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef GUILLOTINE_POLICIES_HPP_
+#define GUILLOTINE_POLICIES_HPP_
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#include "cuboid.hpp"
+#include "free_cuboid.hpp"
+#include "item.hpp"
+#include "rect.hpp"
+
+/**
+ * Heuristics of the guillotine algorithms as policy types. Guillotine2d and
+ * Guillotine3d instantiate their search and split code for every policy
+ * once, so a heuristic is inlined into the loop over free rectangles
+ * (cuboids). A new heuristic is a new policy type, a new value of the
+ * heuristic enum and a new entry of the dispatch table of the algorithm.
+ */
+
+/*
+ * Choice of a free cuboid of Guillotine3d:
+ *   template <class T>
+ *   static float score(item, placed, freeCuboid, binWidth, binDepth)
+ * where T is the coordinate type of the bin, item is the item given to
+ * insert() and placed is the cuboid taken by the item rotated and put into
+ * the corner of freeCuboid. The lowest score wins, ties are won by the free
+ * cuboid which was added first.
+ * If heightIndexed is true, the score is freeCuboid.y + item.height and
+ * the free cuboid may be found with FreeCuboidIndex.
+ */
+
+/* The lowest top of the item, regardless of the orientation. */
+struct CuboidMinHeightScore
+{
+	static const bool heightIndexed = true;
+
+	template <class T>
+	static float score(const BasicItem<T>& item,
+			const BasicCuboid<T>& /*placed*/,
+			const BasicFreeCuboid<T>& freeCuboid, int /*binWidth*/,
+			int /*binDepth*/)
+	{
+		return freeCuboid.y + item.height;
+	}
+};
+
+/* The least free volume left in the free cuboid. The unbounded free cuboid
+ * is used only if the cuboid fits nowhere else. */
+struct CuboidBestVolumeFitScore
+{
+	static const bool heightIndexed = false;
+
+	template <class T>
+	static float score(const BasicItem<T>& item,
+			const BasicCuboid<T>& /*placed*/,
+			const BasicFreeCuboid<T>& freeCuboid, int /*binWidth*/,
+			int /*binDepth*/)
+	{
+		if (freeCuboid.unbounded)
+			return std::numeric_limits<float>::max() / 2;
+		return float(freeCuboid.width) * freeCuboid.height * freeCuboid.depth -
+				item.volume;
+	}
+};
+
+/* The shortest leftover edge of the free cuboid. The leftover height of an
+ * unbounded free cuboid is not counted. */
+struct CuboidBestShortSideFitScore
+{
+	static const bool heightIndexed = false;
+
+	template <class T>
+	static float score(const BasicItem<T>& /*item*/,
+			const BasicCuboid<T>& placed,
+			const BasicFreeCuboid<T>& freeCuboid, int /*binWidth*/,
+			int /*binDepth*/)
+	{
+		float leftover = std::min<float>(freeCuboid.width - placed.width,
+				freeCuboid.depth - placed.depth);
+		if (!freeCuboid.unbounded)
+			leftover = std::min<float>(leftover,
+					freeCuboid.height - placed.height);
+		return leftover;
+	}
+};
+
+/* The lowest top of the cuboid in the given orientation. Ties are won by
+ * the largest part of the surface of the cuboid touching the floor and the
+ * walls of the bin. */
+struct CuboidContactAreaScore
+{
+	static const bool heightIndexed = false;
+
+	template <class T>
+	static float score(const BasicItem<T>& /*item*/,
+			const BasicCuboid<T>& placed,
+			const BasicFreeCuboid<T>& freeCuboid, int binWidth, int binDepth)
+	{
+		const float bottom = float(placed.width) * placed.depth;
+		const float side = float(placed.height) * placed.depth;
+		const float front = float(placed.width) * placed.height;
+
+		float contact = 0;
+		if (freeCuboid.y == 0)
+			contact += bottom;
+		if (freeCuboid.x == 0)
+			contact += side;
+		if (freeCuboid.x + placed.width == binWidth)
+			contact += side;
+		if (freeCuboid.z == 0)
+			contact += front;
+		if (freeCuboid.z + placed.depth == binDepth)
+			contact += front;
+
+		// The part is below 1, so it only orders cuboids with the same top
+		// for whole sizes.
+		const float part = contact / (2 * (bottom + side + front));
+		return freeCuboid.y + placed.height - part;
+	}
+};
+
+/*
+ * Split of a free cuboid of Guillotine3d after placedCuboid was put into
+ * it:
+ *   template <class T>
+ *   static bool splitHorizontal(freeCuboid, placedCuboid)
+ */
+
+/* Split along the shorter leftover axis. */
+struct CuboidSplitShorterLeftoverAxis
+{
+	template <class T>
+	static bool splitHorizontal(const BasicFreeCuboid<T>& freeCuboid,
+			const BasicCuboid<T>& placed)
+	{
+		const auto w = freeCuboid.width - placed.width;
+		const auto d = freeCuboid.depth - placed.depth;
+		return w <= d;
+	}
+};
+
+/* Split along the longer leftover axis. */
+struct CuboidSplitLongerLeftoverAxis
+{
+	template <class T>
+	static bool splitHorizontal(const BasicFreeCuboid<T>& freeCuboid,
+			const BasicCuboid<T>& placed)
+	{
+		const auto w = freeCuboid.width - placed.width;
+		const auto d = freeCuboid.depth - placed.depth;
+		return w > d;
+	}
+};
+
+/* Split along the shorter total axis. */
+struct CuboidSplitShorterAxis
+{
+	template <class T>
+	static bool splitHorizontal(const BasicFreeCuboid<T>& freeCuboid,
+			const BasicCuboid<T>& /*placed*/)
+	{
+		return freeCuboid.width <= freeCuboid.depth;
+	}
+};
+
+/* Split along the longer total axis. */
+struct CuboidSplitLongerAxis
+{
+	template <class T>
+	static bool splitHorizontal(const BasicFreeCuboid<T>& freeCuboid,
+			const BasicCuboid<T>& /*placed*/)
+	{
+		return freeCuboid.width > freeCuboid.depth;
+	}
+};
+
+/*
+ * Choice of a free rectangle of Guillotine2d:
+ *   static int score(rect, freeRect)
+ * The lowest score wins.
+ */
+
+struct RectBestAreaFitScore
+{
+	static int score(const Rect& rect, const Rect& freeRect)
+	{
+		return freeRect.width * freeRect.height - rect.width * rect.height;
+	}
+};
+
+struct RectBestShortSideFitScore
+{
+	static int score(const Rect& rect, const Rect& freeRect)
+	{
+		int leftoverHoriz = std::abs(freeRect.width - rect.width);
+		int leftoverVert = std::abs(freeRect.height - rect.height);
+		return std::min(leftoverHoriz, leftoverVert);
+	}
+};
+
+/*
+ * Split of a free rectangle of Guillotine2d after placedRect was put into
+ * it:
+ *   static bool splitHorizontal(freeRect, placedRect)
+ */
+
+struct RectSplitShorterLeftoverAxis
+{
+	static bool splitHorizontal(const Rect& freeRect, const Rect& placedRect)
+	{
+		const int w = freeRect.width - placedRect.width;
+		const int h = freeRect.height - placedRect.height;
+		return w <= h;
+	}
+};
+
+struct RectSplitLongerLeftoverAxis
+{
+	static bool splitHorizontal(const Rect& freeRect, const Rect& placedRect)
+	{
+		const int w = freeRect.width - placedRect.width;
+		const int h = freeRect.height - placedRect.height;
+		return w > h;
+	}
+};
+
+struct RectSplitShorterAxis
+{
+	static bool splitHorizontal(const Rect& freeRect, const Rect& /*placedRect*/)
+	{
+		return freeRect.width <= freeRect.height;
+	}
+};
+
+struct RectSplitLongerAxis
+{
+	static bool splitHorizontal(const Rect& freeRect, const Rect& /*placedRect*/)
+	{
+		return freeRect.width > freeRect.height;
+	}
+};
+
+#endif /* GUILLOTINE_POLICIES_HPP_ */
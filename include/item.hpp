@@ -0,0 +1,133 @@
+//============================================================================
+// Name        : item.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef ITEM_HPP_
+#define ITEM_HPP_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "cuboid.hpp"
+
+/* Orientations of an item in the order they are tried by Guillotine3d.
+ * Every row holds indexes of edges of the item (0 - width, 1 - height,
+ * 2 - depth) placed along the width, height and depth of a bin. */
+extern const int itemOrientations[6][3];
+
+/* Sort three edges in increasing order, without calling std::sort. */
+template <class T>
+inline void sortEdges(T edges[3])
+{
+	const T low = std::min(edges[0], edges[1]);
+	const T high = std::max(edges[0], edges[1]);
+	const T last = edges[2];
+	edges[0] = std::min(low, last);
+	edges[1] = std::max(low, std::min(high, last));
+	edges[2] = std::max(high, last);
+}
+
+/**
+ * Cuboid to be packed by the guillotine algorithm: its id and size, which
+ * never change, with the sorted edges and the volume computed once.
+ */
+template <class T>
+class BasicItem {
+public:
+	BasicItem() {}
+	BasicItem(unsigned id, T width, T height, T depth) :
+		id(id), width(width), height(height), depth(depth),
+		volume(float(width) * height * depth)
+	{
+		sortedEdges[0] = width;
+		sortedEdges[1] = height;
+		sortedEdges[2] = depth;
+		sortEdges(sortedEdges);
+	}
+
+	/* Item of an input cuboid, with the same id. */
+	template <class U>
+	explicit BasicItem(const BasicCuboid<U>& cuboid) :
+		BasicItem(cuboid.id, T(cuboid.width), T(cuboid.height),
+				T(cuboid.depth)) {}
+
+	/* Edge with the given index (0 - width, 1 - height, 2 - depth). */
+	T edge(int index) const
+	{
+		return index == 0 ? width : (index == 1 ? height : depth);
+	}
+
+	T maxEdge() const { return sortedEdges[2]; }
+
+	static bool compareMaxEdge(const BasicItem& i, const BasicItem& j)
+	{
+		return i.maxEdge() > j.maxEdge();
+	}
+
+	unsigned id;
+	T width;
+	T height;
+	T depth;
+
+	/* Edges in increasing order. */
+	T sortedEdges[3];
+
+	float volume;
+};
+
+/**
+ * Item put into a bin: the id of the item, its orientation (a row of
+ * itemOrientations) and the position of its corner with the lowest
+ * coordinates. The size is taken from the item.
+ */
+template <class T>
+struct BasicPlacement
+{
+	unsigned id;
+	uint8_t orientation;
+	T x;
+	T y;
+	T z;
+
+	T width(const BasicItem<T>& item) const
+	{
+		return item.edge(itemOrientations[orientation][0]);
+	}
+
+	T height(const BasicItem<T>& item) const
+	{
+		return item.edge(itemOrientations[orientation][1]);
+	}
+
+	T depth(const BasicItem<T>& item) const
+	{
+		return item.edge(itemOrientations[orientation][2]);
+	}
+
+	/* Cuboid taken by the placed item. */
+	BasicCuboid<T> cuboid(const BasicItem<T>& item) const
+	{
+		assert(item.id == id);
+		BasicCuboid<T> c(width(item), height(item), depth(item));
+		c.x = x;
+		c.y = y;
+		c.z = z;
+		c.isPlaced = true;
+		c.id = id;
+		return c;
+	}
+
+	bool operator==(const BasicPlacement& other) const
+	{
+		return id == other.id && orientation == other.orientation &&
+				x == other.x && y == other.y && z == other.z;
+	}
+};
+
+typedef BasicItem<float> Item;
+typedef BasicPlacement<float> Placement;
+
+#endif /* ITEM_HPP_ */
@@ -0,0 +1,44 @@
+//============================================================================
+// Name        : mapped_file.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef MAPPED_FILE_HPP_
+#define MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Read only file mapped into memory, or read into a buffer where mapping is
+ * not available. Pages are read on first access, so opening a file does not
+ * read it.
+ */
+class MappedFile {
+public:
+	MappedFile() : fileData(0), fileSize(0), mapped(false) {}
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/* @return false if the file can not be read, see getError(). */
+	bool open(const char* filename);
+	void close();
+
+	/* Contents of the file, null for an empty file. */
+	const char* data() const { return fileData; }
+	size_t size() const { return fileSize; }
+
+	const std::string& getError() const { return error; }
+
+private:
+	const char* fileData;
+	size_t fileSize;
+	bool mapped;
+	std::string buffer;
+	std::string error;
+};
+
+#endif /* MAPPED_FILE_HPP_ */
@@ -0,0 +1,126 @@
+//============================================================================
+// Name        : packer.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef PACKER_HPP_
+#define PACKER_HPP_
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "cuboid.hpp"
+#include "guillotine3d.hpp"
+#include "placement_sink.hpp"
+#include "shelf_algorithm.hpp"
+
+/**
+ * Common interface of the shelf, guillotine and global guillotine engines of
+ * libbinpacking.
+ *
+ * A packer is meant to be kept for many jobs: pack() empties the bin before
+ * packing and reset() changes its base, both keep the memory of the engine,
+ * of sorted cuboids and of placed cuboids, so packing a job not larger than
+ * the previous ones does not grow any container.
+ */
+class Packer {
+public:
+	enum Engine
+	{
+		EngineShelf, // Shelves of cuboids sorted by volume.
+		EngineGuillotine, // Guillotine3d with cuboids sorted by the longest
+						  // edge.
+		EngineGlobalGuillotine // Guillotine3d with the order of cuboids
+							   // searched by GlobalSearch.
+	};
+
+	enum Coordinates
+	{
+		CoordinatesFloat,
+		CoordinatesInt32, // Whole sizes only, see BasicGuillotine3d.
+		CoordinatesInt16
+	};
+
+	struct Options
+	{
+		/* Merge free rectangles of shelves or compact free cuboids. */
+		bool compaction = false;
+		ShelfAlgorithm::ShelfChoiceHeuristic shelfChoice =
+				ShelfAlgorithm::ShelfFirstFit;
+		Guillotine3dBase::FreeCuboidChoiceHeuristic cuboidChoice =
+				Guillotine3dBase::CuboidMinHeight;
+		/* Height classes of shelves built in parallel (shelf), or threads of
+		 * branch and bound (global guillotine). */
+		unsigned threads = 1;
+		/* Beam search instead of branch and bound if not 0 (global
+		 * guillotine). */
+		unsigned beamWidth = 0;
+		/* Partial orders visited by branch and bound at most, 0 for an
+		 * exact search (global guillotine). A stopped search returns the
+		 * best order found so far. */
+		unsigned long nodeLimit = 0;
+		/* Coordinate type of the guillotine engine. */
+		Coordinates coordinates = CoordinatesFloat;
+	};
+
+	static std::unique_ptr<Packer> create(Engine engine, int width,
+			int depth, const Options& options);
+
+	/* Packer with default options. */
+	static std::unique_ptr<Packer> create(Engine engine, int width,
+			int depth);
+
+	virtual ~Packer() {}
+
+	/* Empty the bin and set its base. */
+	virtual void reset(int width, int depth) = 0;
+
+	/**
+	 * Empty the bin and pack the cuboids. Placed cuboids keep ids of the
+	 * input cuboids. They are passed to the sink, if it is not null, as soon
+	 * as their places are final: one by one by the shelf and guillotine
+	 * engines, after the search by the global guillotine engine.
+	 * @return Number of cuboids not placed.
+	 */
+	virtual size_t pack(const std::vector<Cuboid>& cuboids,
+			PlacementSink* sink) = 0;
+
+	size_t pack(const std::vector<Cuboid>& cuboids)
+	{
+		return pack(cuboids, 0);
+	}
+
+	/* Cuboids placed by the last pack(), positioned by the corner with the
+	 * lowest coordinates. */
+	virtual const std::vector<Cuboid>& getPlacedCuboids() const = 0;
+
+	virtual float getFilledBinHeight() const = 0;
+
+	/* Print statistics of the engine for the last pack(), e.g. of merged
+	 * free rectangles. */
+	virtual void printStats(std::ostream& out) const = 0;
+};
+
+/**
+ * Cuboids taken by items placed into a guillotine bin, in the order of
+ * placements. Ids of items are positions of cuboids in the input, placed
+ * cuboids keep ids of the input cuboids.
+ */
+template <class T>
+void placedCuboids(const BasicGuillotine3d<T>& bin,
+		const std::vector<Cuboid>& cuboids, std::vector<Cuboid>& placed)
+{
+	placed.clear();
+	for (const BasicPlacement<T>& placement : bin.getPlacements())
+	{
+		const Cuboid& input = cuboids[placement.id];
+		BasicItem<T> item(placement.id, T(input.width), T(input.height),
+				T(input.depth));
+		placed.push_back(Cuboid(placement.cuboid(item)));
+		placed.back().id = input.id;
+	}
+}
+
+#endif /* PACKER_HPP_ */
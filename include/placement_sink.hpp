@@ -0,0 +1,24 @@
+//============================================================================
+// Name        : placement_sink.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef PLACEMENT_SINK_HPP_
+#define PLACEMENT_SINK_HPP_
+
+#include "cuboid.hpp"
+
+/**
+ * Receiver of placed cuboids, passed by an engine as soon as a placement is
+ * final, in the order of the placed cuboids of the engine. Cuboids are
+ * positioned by the corner with the lowest coordinates.
+ */
+class PlacementSink {
+public:
+	virtual ~PlacementSink() {}
+
+	virtual void place(const Cuboid& cuboid) = 0;
+};
+
+#endif /* PLACEMENT_SINK_HPP_ */
@@ -0,0 +1,51 @@
+//============================================================================
+// Name        : placement_writer.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef PLACEMENT_WRITER_HPP_
+#define PLACEMENT_WRITER_HPP_
+
+#include <fstream>
+#include <thread>
+
+#include "cuboid.hpp"
+#include "placement_sink.hpp"
+#include "rect.hpp"
+#include "spsc_queue.hpp"
+
+/**
+ * Sink saving placed cuboids to an xml file on its own thread, while the
+ * engine goes on packing. Cuboids pass through a bounded queue and are
+ * transformed one by one, so the file is the same as the one saved by
+ * saveXml(transform(placed), base, filename) without holding a copy of the
+ * placed cuboids. Only the packing thread may call place().
+ */
+class PlacementWriter : public PlacementSink {
+public:
+	/* Open the file and start the writer thread. */
+	explicit PlacementWriter(const char* filename, size_t capacity = 4096);
+
+	/* Finish without a base, unless finish() was called. */
+	~PlacementWriter();
+
+	PlacementWriter(const PlacementWriter&) = delete;
+	PlacementWriter& operator=(const PlacementWriter&) = delete;
+
+	void place(const Cuboid& cuboid) override { queue.push(cuboid); }
+
+	/* Save the base of the bin unless it is empty, after all placed
+	 * cuboids, and wait for the writer thread to close the file. */
+	void finish(const Rect& base);
+
+private:
+	std::ofstream ofs;
+	SpscQueue<Cuboid> queue;
+	Rect base;
+	std::thread writer;
+
+	void write();
+};
+
+#endif /* PLACEMENT_WRITER_HPP_ */
@@ -6,31 +6,117 @@
 #ifndef SHELF_ALGORITHM_HPP
 #define SHELF_ALGORITHM_HPP
 
+#include <functional>
+#include <memory_resource>
+#include <set>
+#include <utility>
+
 #include "rect.hpp"
 #include "cuboid.hpp"
+#include "item.hpp"
 #include "guillotine2d.hpp"
+#include "placement_sink.hpp"
+#include "shelf_capacity_index.hpp"
 
 
 class ShelfAlgorithm{
 public:
 	ShelfAlgorithm() : binWidth(0), binHeight(std::numeric_limits<float>::max()),
-		binDepth(0), currentY(0) {}
-	ShelfAlgorithm(float width, float depth);
-
-	void init(float width, float depth);
+		binDepth(0), currentY(0), filledHeight(-1),
+		splitMethod(Guillotine2d::SplitLongerLeftoverAxis),
+		mergeEnabled(false), resource(std::pmr::get_default_resource()),
+		shelves(resource), shelfIndex(resource), shelvesByHeight(resource),
+		shelvesByArea(resource), lastShelf(0), maxOpenShelves(0),
+		placementSink(0) {}
+
+	/* Shelves and their free rectangles are allocated from the given memory
+	 * resource, e.g. a pool kept between packings, so that inserting does
+	 * not allocate memory from the heap. */
+	ShelfAlgorithm(float width, float depth,
+			std::pmr::memory_resource* resource =
+					std::pmr::get_default_resource());
+
+	/* Initialize an empty bin, with unlimited height by default. */
+	void init(float width, float depth,
+			float height = std::numeric_limits<float>::max());
 	enum ShelfChoiceHeuristic
 	{
 		ShelfNextFit, // We always put the new cuboid to the last open shelf.
 		ShelfFirstFit, // We test each cuboid against each shelf in turn and
 					   // pack it to the first where it fits.
+		ShelfBestHeightFit, // The shelf and the edge standing vertically
+							// which leave the least shelf height above it.
+		ShelfBestAreaFit, // The shelf with the least free area it fits.
+		ShelfWorstAreaFit // The shelf with the most free area it fits.
 	};
 
 	Cuboid insert(const Cuboid& cuboid, ShelfChoiceHeuristic method);
 	std::vector<Cuboid> insert(const std::vector<Cuboid>& cuboids,
 			ShelfChoiceHeuristic method);
 
-	float getFilledBinHeight();
-	std::vector<Cuboid> getUsedCuboids() { return usedCuboids; }
+	/* Receives placed cuboids of a closed shelf. */
+	typedef std::function<void(const std::vector<Cuboid>&)> ShelfSink;
+
+	/**
+	 * Insert the remaining cuboids of the input and pass the placed ones to
+	 * the sink, shelf by shelf. A shelf is closed as soon as it can not hold
+	 * any of the remaining cuboids: its cuboids are passed to the sink and
+	 * its guillotine storage is freed, so memory grows with the number of
+	 * open shelves, not with the number of placed cuboids. Cuboids are placed
+	 * the same as by insert(), every shelf is closed at the end.
+	 * @return Number of cuboids not placed.
+	 */
+	size_t insertStreaming(const std::vector<Cuboid>& cuboids,
+			ShelfChoiceHeuristic method, const ShelfSink& sink);
+
+	/**
+	 * Insert cuboids, building shelves on threads. Cuboids are split into
+	 * height classes by the longest edge, with the same number of cuboids in
+	 * every class, and every class is packed into its own shelves. The
+	 * shelves are stacked from the highest class, but the last shelf of
+	 * every class, filled the least; its cuboids are inserted again into
+	 * gaps of the stacked shelves. The bin is usually higher than with
+	 * insert(), as shelves hold cuboids of one class only.
+	 * @return Number of cuboids not placed.
+	 */
+	size_t insertParallel(const std::vector<Cuboid>& cuboids,
+			ShelfChoiceHeuristic method, unsigned heightClasses,
+			unsigned threads);
+
+	/* The highest number of shelves open at once in insertStreaming(). */
+	size_t getMaxOpenShelves() const { return maxOpenShelves; }
+
+	/* Set the split heuristic used by the guillotine algorithm of shelves
+	 * (SplitLongerLeftoverAxis by default). */
+	void setSplitHeuristic(Guillotine2d::GuillotineSplitHeuristic method)
+	{
+		splitMethod = method;
+	}
+
+	/* Merge free rectangles of shelves sharing a full edge (disabled by
+	 * default), see Guillotine2d::setMergeEnabled(). Has to be set before
+	 * inserting cuboids. */
+	void setMergeEnabled(bool enabled);
+
+	/* Number of merges of free rectangles in all shelves. */
+	unsigned long getMergeCount() const;
+
+	/* Pass every placed cuboid to the sink as soon as its place is final,
+	 * in the order of getUsedCuboids() (none by default). Shelves built by
+	 * insertParallel() are passed once they are stacked. */
+	void setPlacementSink(PlacementSink* sink) { placementSink = sink; }
+
+	float getFilledBinHeight() const;
+	const std::vector<Cuboid>& getUsedCuboids() const { return usedCuboids; }
+
+	/* Maximum of summaries of shelves. */
+	ShelfCapacityIndex::Capacity getShelvesCapacity() const
+	{
+		return shelfIndex.summary();
+	}
+
+	/* Summary of a new shelf on top of the last one. */
+	ShelfCapacityIndex::Capacity getNewShelfCapacity() const;
 
 
 private:
@@ -41,19 +127,112 @@ private:
 	/* Stores the starting y-coordinate of the latest(topmost) shelf. */
 	float currentY;
 
+	/* The highest top of placed cuboids, -1 if there are none. */
+	float filledHeight;
+
+	Guillotine2d::GuillotineSplitHeuristic splitMethod;
+	bool mergeEnabled;
+
+	std::pmr::memory_resource* resource;
+
 	struct Shelf
 	{
+		explicit Shelf(std::pmr::memory_resource* resource) :
+			guillotine(resource) {}
+
 		float startY;
 		float height;
 		Guillotine2d guillotine;
+
+		/* Area of free rectangles. */
+		long freeArea;
+
+		/* Placed cuboids, kept only by insertStreaming(). */
+		std::vector<Cuboid> cuboids;
+		bool closed;
 	};
 
-	std::vector<Shelf> shelves;
+	std::pmr::vector<Shelf> shelves;
 	std::vector<Cuboid> usedCuboids;
 
-	Cuboid putOnShelf(Shelf& shelf, const Cuboid& cuboid);
+	/* Summaries of shelves, used by ShelfFirstFit to skip shelves. */
+	ShelfCapacityIndex shelfIndex;
+
+	/* Open shelves ordered by height (infinite for a shelf without a height
+	 * yet) and by free area, used by best and worst fit heuristics. */
+	typedef std::pmr::set<std::pair<float, size_t> > HeightIndex;
+	typedef std::pmr::set<std::pair<long, size_t> > AreaIndex;
+	HeightIndex shelvesByHeight;
+	AreaIndex shelvesByArea;
+
+	/* Shelf of the last placed cuboid. */
+	size_t lastShelf;
+
+	/* Shelves not closed yet, used by insertStreaming(). */
+	std::vector<size_t> openShelves;
+	size_t maxOpenShelves;
+
+	PlacementSink* placementSink;
+
+	/* Bases of a cuboid in the order they are tried: the longest, the
+	 * middle and the shortest edge set vertically. */
+	struct Orientations
+	{
+		/* Edges sorted in increasing order. */
+		explicit Orientations(const float edges[3]);
+
+		Rect bases[3];
+		float verticals[3];
+	};
+
+	Cuboid putOnShelf(Shelf& shelf, unsigned id,
+			const Orientations& orientations);
+
+	/* Put the cuboid on a shelf in the first of the count orientations,
+	 * starting with the given one, which fits. */
+	Cuboid putOnShelf(Shelf& shelf, unsigned id,
+			const Orientations& orientations, int first, int count);
+
+	/**
+	 * Find a shelf by ShelfBestHeightFit, ShelfBestAreaFit or
+	 * ShelfWorstAreaFit and put the cuboid on it. Shelves are visited in the
+	 * order of their height or free area from the first which could hold the
+	 * cuboid; shelves whose capacity summary or free rectangles do not hold
+	 * it are passed one by one, so the worst case visits every shelf.
+	 * @return Placed cuboid, or a cuboid which is not placed if no shelf
+	 * holds it. The index of the shelf is stored in index.
+	 */
+	Cuboid putOnBestShelf(unsigned id, const float edges[3],
+			const Orientations& orientations, ShelfChoiceHeuristic method,
+			size_t* index);
+
+	/* Height of the shelf, or the height left up to the top of the bin for a
+	 * shelf without a height yet. Key of the shelf in shelvesByHeight. */
+	float maxShelfHeight(const Shelf& shelf) const;
+
+	/* Check if a base fits an empty shelf, upright or sideways. */
+	bool fitsEmptyShelf(const Rect& base) const;
+
+	/* Add a shelf on top of the others, to the indexes of shelves. */
+	void pushShelf(Shelf&& shelf);
+
+	/* Add a placed cuboid to a shelf, its y is set to the bottom of the
+	 * shelf. */
+	void addToShelf(size_t index, Cuboid& newCuboid);
+
+	/* Summary of a shelf for shelfIndex. */
+	ShelfCapacityIndex::Capacity capacity(const Shelf& shelf) const;
+
+	/**
+	 * Check if a shelf may hold a cuboid whose shortest edge is at least
+	 * minShortEdge and middle edge is at least minMiddleEdge.
+	 */
+	bool mayHoldAny(const Shelf& shelf, float minShortEdge,
+			float minMiddleEdge) const;
 
-	void addToShelf(Shelf& shelf, Cuboid newCuboid);
+	/* Pass cuboids of a shelf to the sink, free its storage and skip it in
+	 * ShelfFirstFit. */
+	void closeShelf(size_t index, const ShelfSink& sink);
 
 	/**
 	 * Check if is it possible to start new shelf.
@@ -0,0 +1,92 @@
+//============================================================================
+// Name        : shelf_capacity_index.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef SHELF_CAPACITY_INDEX_HPP_
+#define SHELF_CAPACITY_INDEX_HPP_
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/**
+ * Index over the shelves of ShelfAlgorithm, used to skip shelves which can
+ * not hold a cuboid.
+ *
+ * Every shelf is summarized by its height and the longest short side and
+ * long side of its free rectangles. The summaries are leaves of a segment
+ * tree in the order of shelves, every inner node keeps the maximum of its
+ * children. A cuboid may fit a shelf only if, for some edge standing
+ * vertically, the edge is not higher than the shelf and the two other edges
+ * fit the longest sides. The tree never skips a shelf which can hold the
+ * cuboid and skips whole subtrees which can not.
+ *
+ * The maxima of a node are taken separately, so a node may pass the test
+ * while none of its shelves does. A search then descends into subtrees
+ * without a result: it takes O(log shelves) when the maxima of a node come
+ * from shelves which pass, but O(shelves) in the worst case.
+ */
+class ShelfCapacityIndex {
+public:
+	struct Capacity
+	{
+		/* Height of the shelf, infinite for a shelf without a height yet. */
+		float height;
+		/* Longest short side and long side of free rectangles. */
+		int maxShortSide;
+		int maxLongSide;
+	};
+
+	explicit ShelfCapacityIndex(std::pmr::memory_resource* resource =
+			std::pmr::get_default_resource()) :
+		leaves(0), shelves(0), tree(resource) {}
+
+	void clear();
+
+	size_t size() const { return shelves; }
+
+	/* Add a summary of a new last shelf. */
+	void push_back(const Capacity& capacity);
+
+	void update(size_t shelf, const Capacity& capacity);
+
+	const Capacity& operator[](size_t shelf) const
+	{
+		return tree[leaves + shelf];
+	}
+
+	/* Maximum of summaries of all shelves. */
+	Capacity summary() const;
+
+	/* Check if a shelf of the given summary may hold a cuboid with the given
+	 * edges sorted in increasing order. */
+	static bool mayHold(const Capacity& capacity, const float sortedEdges[3]);
+
+	/**
+	 * Find the first shelf, not earlier than the given one, which may hold
+	 * a cuboid with the given edges sorted in increasing order. Sides of the
+	 * base are compared as whole numbers, the same as Guillotine2d does.
+	 * The shelf may still not hold the cuboid, as its free rectangles are
+	 * summarized; a caller tries the next one by searching again from the
+	 * following shelf, so trying k shelves takes k searches.
+	 * @return Index of the shelf, or size() if there is none.
+	 */
+	size_t findFirst(size_t first, const float sortedEdges[3]) const;
+
+private:
+	/* Number of leaves, a power of two. */
+	size_t leaves;
+	size_t shelves;
+
+	/* Node i has children 2i and 2i + 1, leaves start at index leaves. */
+	std::pmr::vector<Capacity> tree;
+
+	size_t findFirst(size_t node, size_t nodeBegin, size_t nodeEnd,
+			size_t first, const float sortedEdges[3]) const;
+
+	void updateParents(size_t node);
+};
+
+#endif /* SHELF_CAPACITY_INDEX_HPP_ */
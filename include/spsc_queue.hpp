@@ -0,0 +1,147 @@
+//============================================================================
+// Name        : spsc_queue.hpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#ifndef SPSC_QUEUE_HPP_
+#define SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Bounded queue of one producer thread and one consumer thread. Values are
+ * passed through a ring buffer without locking; a side which has to wait
+ * (the producer for a full queue, the consumer for an empty one) spins for
+ * a while and then sleeps, and is woken by the other side only when it
+ * sleeps.
+ */
+template <class T>
+class SpscQueue {
+public:
+	/* Queue of at least the given capacity, rounded up to a power of two. */
+	explicit SpscQueue(size_t capacity);
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/* Producer: add a value, waiting while the queue is full. */
+	void push(const T& value);
+
+	/* Producer: no more values will be pushed. */
+	void close();
+
+	/**
+	 * Consumer: take the next value, waiting while the queue is empty.
+	 * @return false if the queue is closed and empty.
+	 */
+	bool pop(T& value);
+
+private:
+	std::vector<T> buffer;
+	size_t mask;
+
+	/* Positions of the next value to pop and to push, each written by one
+	 * side only, on separate cache lines. */
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+
+	std::atomic<bool> closed;
+	std::atomic<bool> producerSleeping;
+	std::atomic<bool> consumerSleeping;
+	std::mutex mutex;
+	std::condition_variable changed;
+
+	/* Yields of a waiting side before it sleeps. */
+	static const int spins = 64;
+
+	template <class Ready>
+	void wait(const Ready& ready, std::atomic<bool>& sleeping);
+
+	void wake(const std::atomic<bool>& sleeping);
+};
+
+template <class T>
+SpscQueue<T>::SpscQueue(size_t capacity) :
+	head(0), tail(0), closed(false), producerSleeping(false),
+	consumerSleeping(false)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size *= 2;
+	buffer.resize(size);
+	mask = size - 1;
+}
+
+template <class T>
+void SpscQueue<T>::push(const T& value)
+{
+	const size_t t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) == buffer.size())
+		wait([&]() { return t - head.load() < buffer.size(); },
+				producerSleeping);
+	buffer[t & mask] = value;
+	tail.store(t + 1);
+	wake(consumerSleeping);
+}
+
+template <class T>
+void SpscQueue<T>::close()
+{
+	closed.store(true);
+	std::lock_guard<std::mutex> lock(mutex);
+	changed.notify_all();
+}
+
+template <class T>
+bool SpscQueue<T>::pop(T& value)
+{
+	const size_t h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire))
+	{
+		wait([&]() { return h != tail.load() || closed.load(); },
+				consumerSleeping);
+		// Values pushed before close() come first.
+		if (h == tail.load())
+			return false;
+	}
+	value = buffer[h & mask];
+	head.store(h + 1);
+	wake(producerSleeping);
+	return true;
+}
+
+template <class T>
+template <class Ready>
+void SpscQueue<T>::wait(const Ready& ready, std::atomic<bool>& sleeping)
+{
+	for (int i = 0; i < spins; ++i)
+	{
+		if (ready())
+			return;
+		std::this_thread::yield();
+	}
+
+	// The flag is set before checking again, and the other side moves its
+	// position before reading the flag, so one of them sees the other.
+	std::unique_lock<std::mutex> lock(mutex);
+	sleeping.store(true);
+	changed.wait(lock, ready);
+	sleeping.store(false);
+}
+
+template <class T>
+void SpscQueue<T>::wake(const std::atomic<bool>& sleeping)
+{
+	if (sleeping.load())
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		changed.notify_all();
+	}
+}
+
+#endif /* SPSC_QUEUE_HPP_ */
@@ -9,17 +9,29 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <atomic>
 #include <ctime>
+#include <filesystem>
+#include <functional>
+#include <thread>
 #include <boost/archive/tmpdir.hpp>
 #include <boost/serialization/nvp.hpp>
 #include <boost/archive/xml_oarchive.hpp>
-#include <boost/archive/xml_iarchive.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include "../include/columnar_file.hpp"
+#include "../include/container_packer.hpp"
 #include "../include/cuboid.hpp"
+#include "../include/cuboid_io.hpp"
+#include "../include/cuboid_text_parser.hpp"
+#include "../include/cuboid_xml_parser.hpp"
 #include "../include/shelf_algorithm.hpp"
 #include "../include/guillotine2d.hpp"
 #include "../include/guillotine3d.hpp"
+#include "../include/global_search.hpp"
+#include "../include/item.hpp"
+#include "../include/packer.hpp"
+#include "../include/placement_writer.hpp"
 #include "../include/rect.hpp"
 
 using namespace std;
@@ -27,113 +39,84 @@ using namespace std;
 typedef boost::posix_time::ptime Time;
 typedef boost::posix_time::time_duration TimeDuration;
 
-void saveXml(const std::vector<Cuboid>& cuboids, const Rect& base, const char* filename)
-{
-    std::ofstream ofs(filename);
-    assert(ofs.good());
-    boost::archive::xml_oarchive oa(ofs);
-
-    for (Cuboid cuboid : cuboids)
-    {
-        oa << boost::serialization::make_nvp("cuboid", cuboid);
-    }
-    if (base.width != 0 && base.height!=0)
-    	oa << boost::serialization::make_nvp("base", base);
-}
-
-std::vector<Cuboid> loadCuboidsFromXml(const char* filename)
-{
-    std::ifstream ifs(filename);
-    assert(ifs.good());
-    boost::archive::xml_iarchive ia(ifs);
-
-    std::vector<Cuboid> loadedCuboids;
-    try
-    {
-    	while (true)
-        {
-            Cuboid cuboid;
-            ia >> boost::serialization::make_nvp("cuboid",cuboid);
-            loadedCuboids.push_back(cuboid);
-        }
-    }
-    catch(boost::archive::archive_exception const& e) { return loadedCuboids;}
-    return loadedCuboids;
-}
+/* Partial orders visited by the global guillotine branch and bound unless
+ * -nodes is given: seconds for inputs of a hundred cuboids. */
+const unsigned long defaultNodeLimit = 1000000;
 
 /**
- * Generate random cuboids.
- * @number Number of cuboids.
- * @parameter 3 - every edge size is the same
- * 			  2 - two edges have the same size
- * 			  1 - every edge size is different.
+ * Pack cuboids with an engine of libbinpacking and save the placed ones. An
+ * xml file is written by a PlacementWriter while packing goes on; a columnar
+ * file needs the number of placed cuboids, so it is saved at the end. The
+ * render buffer of the viewer is saved too, unless renderFile is empty.
  */
-vector<Cuboid> generateRandomCuboids(int number, int parameter)
+void packerAlgorithm(Packer::Engine engine, int binWidth, int binDepth, const vector<Cuboid>& cuboids,
+		string filename, string renderFile, bool timeMeasurement, const Packer::Options& options)
 {
-	const int maxSize = 100;
-	vector<Cuboid> cuboids;
-	for (int i = 0; i < number; ++i)
-	{
-		int height;
-		int depth;
-		int width = rand() % maxSize + 1;
-		if (parameter == 3)
-		{
-			height = width;
-			depth = width;
-		}
-		else if (parameter == 2)
-		{
-			depth = width;
-			height = rand() % maxSize + 1;
-		}
-		else
-		{
-			height = rand() % maxSize + 1;
-			depth = rand() % maxSize + 1;
-		}
-		Cuboid c(width, height, depth);
-		cuboids.push_back(c);
-	}
-	return cuboids;
-}
+	unique_ptr<Packer> packer = Packer::create(engine, binWidth, binDepth, options);
+	Rect base(binWidth, binDepth);
+	unique_ptr<PlacementWriter> writer;
+	if (!isColumnarFile(filename.c_str()))
+		writer.reset(new PlacementWriter(filename.c_str()));
 
+	Time t1(boost::posix_time::microsec_clock::local_time());
 
-/**
- * Transform cuboids before displaying in Three.js
- */
-vector<Cuboid> transform(const vector<Cuboid>& cuboids)
-{
-	vector<Cuboid> tranformed;
-	for (Cuboid c : cuboids)
+	size_t notPlaced = packer->pack(cuboids, writer.get());
+
+	if (timeMeasurement)
 	{
-		Cuboid newCuboid;
-	    newCuboid.x = c.x + (0.5 * c.width);
-	    newCuboid.z = c.z + (0.5 * c.depth);
-	    newCuboid.y = c.y + 0.5 * c.height;
-	    newCuboid.width = c.width;
-	    newCuboid.depth = c.depth;
-	    newCuboid.height = c.height;
-	    tranformed.push_back(newCuboid);
+		Time t2(boost::posix_time::microsec_clock::local_time());
+		TimeDuration dt = t2 - t1;
+
+		//number of elapsed miliseconds
+		long msec = dt.total_milliseconds();
+		cout << "It took me: " << msec << endl;
 	}
-	return tranformed;
 
+	// Save the output
+	if (writer)
+		writer->finish(base);
+	else
+		savePlacedCuboids(packer->getPlacedCuboids(), cuboids, base, filename.c_str());
+	if (!renderFile.empty())
+		saveRenderBuffer(packer->getPlacedCuboids(), base, renderFile.c_str());
+	if (notPlaced > 0)
+		cout << "Place not found for " << notPlaced << " cuboids." << endl;
+	cout << "Bin height: " << packer->getFilledBinHeight() << endl;
+	packer->printStats(cout);
 }
 
-void shelfAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboids, string filename, bool timeMeasurement)
+/**
+ * Shelf algorithm saving cuboids of every shelf as soon as the shelf is
+ * closed, so placed cuboids are not kept until the end. Cuboids are saved
+ * shelf by shelf, not in the order of placing.
+ */
+void shelfStreamingAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboids, string filename,
+		bool timeMeasurement, bool compaction, ShelfAlgorithm::ShelfChoiceHeuristic shelfChoice)
 {
 	ShelfAlgorithm shelfAlg(binWidth, binDepth);
+	shelfAlg.setMergeEnabled(compaction);
+	Rect base(binWidth, binDepth);
 
 	Time t1(boost::posix_time::microsec_clock::local_time());
 
 	// Sort cuboids
 	sort(cuboids.begin(), cuboids.end(), &Cuboid::compareVolume);
 
-	// Insert cuboids
-	shelfAlg.insert(cuboids, ShelfAlgorithm::ShelfFirstFit);
+	std::ofstream ofs(filename.c_str());
+	assert(ofs.good());
+	boost::archive::xml_oarchive oa(ofs);
+
+	size_t notPlaced = shelfAlg.insertStreaming(cuboids, shelfChoice,
+		[&oa](const vector<Cuboid>& shelfCuboids)
+		{
+			for (Cuboid cuboid : transform(shelfCuboids))
+				oa << boost::serialization::make_nvp("cuboid", cuboid);
+		});
+	oa << boost::serialization::make_nvp("base", base);
 
-	vector<Cuboid> placedCuboids = shelfAlg.getUsedCuboids();
-	vector<Cuboid> transformedCuboids = transform(placedCuboids);
+	if (notPlaced > 0)
+		cout << "Place not found for " << notPlaced << " cuboids." << endl;
+	cout << "Open shelves at most: " << shelfAlg.getMaxOpenShelves() << endl;
 
 	if (timeMeasurement)
 	{
@@ -145,26 +128,30 @@ void shelfAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboids, string f
 		cout << "It took me: " << msec << endl;
 	}
 
-	// Save the output xml
-	Rect base(binWidth, binDepth);
-	saveXml(transformedCuboids, base, filename.c_str());
 	cout << "Bin height: " << shelfAlg.getFilledBinHeight() << endl;
+	if (compaction)
+		cout << "Free rectangles merged: " << shelfAlg.getMergeCount() << endl;
 }
 
-void guillotineAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboids, string filename, bool timeMeasurement)
+void containerAlgorithm(int binWidth, int binDepth, int binHeight, const vector<Cuboid>& input, string filename,
+		string renderFile, bool timeMeasurement, bool compaction, ShelfAlgorithm::ShelfChoiceHeuristic shelfChoice)
 {
-	Guillotine3d guillotineAlg(binWidth, binDepth);
+	ContainerPacker packer(binWidth, binDepth, binHeight);
+	packer.setMergeEnabled(compaction);
+	Rect base(binWidth, binDepth);
+	unique_ptr<PlacementWriter> writer;
+	if (!isColumnarFile(filename.c_str()))
+		writer.reset(new PlacementWriter(filename.c_str()));
+	packer.setPlacementSink(writer.get());
 
 	Time t1(boost::posix_time::microsec_clock::local_time());
 
 	// Sort cuboids
-	sort(cuboids.begin(), cuboids.end(), &Cuboid::compareMaxEdge);
+	vector<Cuboid> cuboids = input;
+	sort(cuboids.begin(), cuboids.end(), &Cuboid::compareVolume);
 
 	// Insert cuboids
-	guillotineAlg.insertVector(cuboids, Guillotine3d::CuboidMinHeight, Guillotine3d::SplitLongerLeftoverAxis);
-
-	vector<Cuboid> placedCuboids = guillotineAlg.getUsedCuboids();
-	vector<Cuboid> newCuboids = transform(placedCuboids);
+	size_t notPlaced = packer.insert(cuboids, shelfChoice);
 
 	if (timeMeasurement)
 	{
@@ -177,22 +164,194 @@ void guillotineAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboids, str
 	}
 
 	// Save the output
-	Rect base(binWidth, binDepth);
-	saveXml(newCuboids, base, filename.c_str());
-	cout << "Bin height: " << guillotineAlg.getFilledBinHeight() << endl;
+	if (writer)
+		writer->finish(base);
+	else
+		savePlacedCuboids(packer.getUsedCuboids(), input, base, filename.c_str());
+	if (!renderFile.empty())
+		saveRenderBuffer(packer.getUsedCuboids(), base, renderFile.c_str(), binHeight);
+	if (notPlaced > 0)
+		cout << "Place not found for " << notPlaced << " cuboids." << endl;
+	cout << "Containers: " << packer.getContainerCount() << endl;
+	if (compaction)
+		cout << "Free rectangles merged: " << packer.getMergeCount() << endl;
 }
 
-void guillotineGlobalAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboids, string filename, bool timeMeasurement)
+/**
+ * Parse a name of a shelf choice heuristic of the shelf algorithm.
+ * @return false if the name is unknown.
+ */
+bool parseShelfChoice(const string& name, ShelfAlgorithm::ShelfChoiceHeuristic* shelfChoice)
 {
-	Guillotine3d guillotineAlg(binWidth, binDepth);
+	if (name == "first_fit")
+		*shelfChoice = ShelfAlgorithm::ShelfFirstFit;
+	else if (name == "next_fit")
+		*shelfChoice = ShelfAlgorithm::ShelfNextFit;
+	else if (name == "best_height")
+		*shelfChoice = ShelfAlgorithm::ShelfBestHeightFit;
+	else if (name == "best_area")
+		*shelfChoice = ShelfAlgorithm::ShelfBestAreaFit;
+	else if (name == "worst_area")
+		*shelfChoice = ShelfAlgorithm::ShelfWorstAreaFit;
+	else
+		return false;
+	return true;
+}
+
+/**
+ * Parse a name of a free cuboid choice heuristic of the guillotine algorithm.
+ * @return false if the name is unknown.
+ */
+bool parseCuboidChoice(const string& name, Guillotine3d::FreeCuboidChoiceHeuristic* cuboidChoice)
+{
+	if (name == "min_height")
+		*cuboidChoice = Guillotine3d::CuboidMinHeight;
+	else if (name == "best_volume")
+		*cuboidChoice = Guillotine3d::CuboidBestVolumeFit;
+	else if (name == "best_short_side")
+		*cuboidChoice = Guillotine3d::CuboidBestShortSideFit;
+	else if (name == "contact_area")
+		*cuboidChoice = Guillotine3d::CuboidContactArea;
+	else
+		return false;
+	return true;
+}
+
+/**
+ * Check if cuboids can be packed with integer coordinates of type T: all
+ * sizes have to be whole and every coordinate, up to a bin height of all
+ * cuboids stacked on their longest edges, has to fit T.
+ */
+template <class T>
+bool fitsCoordinates(int binWidth, int binDepth, const vector<Cuboid>& cuboids)
+{
+	const double maxCoordinate = BasicFreeCuboid<T>::unboundedHeight() - 1;
+	double height = 0;
+	for (const Cuboid& c : cuboids)
+	{
+		for (float edge : {c.width, c.height, c.depth})
+			if (edge != int(edge))
+				return false;
+		height += max({c.width, c.height, c.depth});
+	}
+	return binWidth <= maxCoordinate && binDepth <= maxCoordinate && height <= maxCoordinate;
+}
+
+/**
+ * One combination of an algorithm, a shelf choice heuristic (shelf only), a
+ * sort key and a split heuristic tried by the portfolio algorithm.
+ */
+struct PortfolioEntry
+{
+	string name;
+	bool shelf;
+	ShelfAlgorithm::ShelfChoiceHeuristic shelfChoice;
+	bool (*compare)(Cuboid, Cuboid);
+	int split;
+
+	float height;
+	long msec;
+	size_t notPlaced;
+	vector<Cuboid> placedCuboids;
+};
 
+void runPortfolioEntry(int binWidth, int binDepth, const vector<Cuboid>& input, PortfolioEntry& entry)
+{
 	Time t1(boost::posix_time::microsec_clock::local_time());
 
-	// Insert cuboids
-	guillotineAlg.insertBestGlobal(cuboids, Guillotine3d::CuboidMinHeight, Guillotine3d::SplitLongerLeftoverAxis);
+	vector<Cuboid> cuboids = input;
+	sort(cuboids.begin(), cuboids.end(), entry.compare);
+
+	// Cuboids are inserted one by one, as inserting a vector prints cuboids
+	// which are not placed; entries run on threads, so they are counted and
+	// reported after all entries have finished.
+	entry.notPlaced = 0;
+	if (entry.shelf)
+	{
+		ShelfAlgorithm shelfAlg(binWidth, binDepth);
+		shelfAlg.setSplitHeuristic(Guillotine2d::GuillotineSplitHeuristic(entry.split));
+		for (const Cuboid& cuboid : cuboids)
+			if (!shelfAlg.insert(cuboid, entry.shelfChoice).isPlaced)
+				++entry.notPlaced;
+		entry.height = shelfAlg.getFilledBinHeight();
+		entry.placedCuboids = shelfAlg.getUsedCuboids();
+	}
+	else
+	{
+		Guillotine3d guillotineAlg(binWidth, binDepth);
+		for (const Cuboid& cuboid : cuboids)
+			if (!guillotineAlg.insert(Item(cuboid), Guillotine3d::CuboidMinHeight,
+					Guillotine3d::GuillotineSplitHeuristic(entry.split)))
+				++entry.notPlaced;
+		entry.height = guillotineAlg.getFilledBinHeight();
+		placedCuboids(guillotineAlg, input, entry.placedCuboids);
+	}
+
+	Time t2(boost::posix_time::microsec_clock::local_time());
+	entry.msec = (t2 - t1).total_milliseconds();
+}
+
+/**
+ * Run every combination of the algorithm (shelf with every shelf choice
+ * heuristic but next fit, guillotine), the sort key (volume, longest edge)
+ * and the split heuristic on its own thread and keep the packing with the
+ * lowest bin height. Next fit tries only the last shelf, it is meant for
+ * speed, not for the height a portfolio looks for.
+ */
+void portfolioAlgorithm(int binWidth, int binDepth, const vector<Cuboid>& cuboids, string filename,
+		string renderFile, bool timeMeasurement)
+{
+	const char* splitNames[] = {"SplitShorterLeftoverAxis", "SplitLongerLeftoverAxis",
+			"SplitShorterAxis", "SplitLongerAxis"};
+	const pair<ShelfAlgorithm::ShelfChoiceHeuristic, const char*> shelfChoices[] = {
+		{ShelfAlgorithm::ShelfFirstFit, "shelf"},
+		{ShelfAlgorithm::ShelfBestHeightFit, "shelf best_height"},
+		{ShelfAlgorithm::ShelfBestAreaFit, "shelf best_area"},
+		{ShelfAlgorithm::ShelfWorstAreaFit, "shelf worst_area"}
+	};
+
+	// The last algorithm is the guillotine one.
+	vector<PortfolioEntry> entries;
+	for (size_t algorithm = 0; algorithm <= 4; ++algorithm)
+	{
+		const bool shelf = algorithm < 4;
+		for (int volume = 1; volume >= 0; --volume)
+		{
+			for (int split = 0; split < 4; ++split)
+			{
+				PortfolioEntry entry;
+				entry.name = string(shelf ? shelfChoices[algorithm].second : "guillotine") +
+						(volume ? " volume " : " max_edge ") + splitNames[split];
+				entry.shelf = shelf;
+				entry.shelfChoice = shelf ? shelfChoices[algorithm].first :
+						ShelfAlgorithm::ShelfFirstFit;
+				entry.compare = volume ? &Cuboid::compareVolume : &Cuboid::compareMaxEdge;
+				entry.split = split;
+				entries.push_back(entry);
+			}
+		}
+	}
 
-	vector<Cuboid> placedCuboids = guillotineAlg.getUsedCuboids();
-	vector<Cuboid> newCuboids = transform(placedCuboids);
+	Time t1(boost::posix_time::microsec_clock::local_time());
+
+	// Threads share the input, every entry sorts a copy of its own.
+	vector<thread> threads;
+	for (PortfolioEntry& entry : entries)
+		threads.push_back(thread(runPortfolioEntry, binWidth, binDepth, cref(cuboids), ref(entry)));
+	for (thread& t : threads)
+		t.join();
+
+	size_t best = 0;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		cout << entries[i].name << ": height " << entries[i].height << ", "
+			<< entries[i].msec << " ms";
+		if (entries[i].notPlaced > 0)
+			cout << ", place not found for " << entries[i].notPlaced << " cuboids";
+		cout << endl;
+		if (entries[i].height < entries[best].height)
+			best = i;
+	}
 
 	if (timeMeasurement)
 	{
@@ -206,17 +365,538 @@ void guillotineGlobalAlgorithm(int binWidth, int binDepth, vector<Cuboid> cuboid
 
 	// Save the output
 	Rect base(binWidth, binDepth);
-	saveXml(newCuboids, base, filename.c_str());
-	cout << "Bin height: " << guillotineAlg.getFilledBinHeight() << endl;
+	savePlacedCuboids(entries[best].placedCuboids, cuboids, base, filename.c_str());
+	if (!renderFile.empty())
+		saveRenderBuffer(entries[best].placedCuboids, base, renderFile.c_str());
+	cout << "Best: " << entries[best].name << endl;
+	cout << "Bin height: " << entries[best].height << endl;
+}
+
+/**
+ * Time fitMasks() of every fit kernel on the free cuboids left by packing
+ * the cuboids with coordinates of type T: every cuboid is tested against
+ * all free cuboids. Every kernel has to give the same masks.
+ */
+template <class T>
+void fitMasksBenchmark(const string& file, const char* typeName, int binWidth,
+		int binDepth, const vector<Cuboid>& cuboids)
+{
+	const FreeCuboidStoreBase::FitKernel kernels[] = {
+		FreeCuboidStoreBase::FitKernelScalar,
+		FreeCuboidStoreBase::FitKernelSse,
+		FreeCuboidStoreBase::FitKernelAvx2
+	};
+
+	vector<BasicItem<T> > items;
+	items.reserve(cuboids.size());
+	for (const Cuboid& c : cuboids)
+		items.push_back(BasicItem<T>(c));
+	BasicGuillotine3d<T> bin(binWidth, binDepth);
+	bin.insertVector(items, Guillotine3dBase::CuboidMinHeight,
+			Guillotine3dBase::SplitLongerLeftoverAxis);
+	BasicFreeCuboidStore<T> store = bin.getFreeCuboids();
+	const double tests = double(items.size()) * store.size();
+
+	long scalarUsec = 0;
+	uint64_t scalarChecksum = 0;
+	for (FreeCuboidStoreBase::FitKernel kernel : kernels)
+	{
+		const string name = file + " " + typeName + " " +
+				FreeCuboidStoreBase::fitKernelName(kernel);
+		if (!store.setFitKernel(kernel))
+		{
+			cout << name << ": not supported" << endl;
+			continue;
+		}
+
+		// Masks are summed, so the tests are not optimized away and kernels
+		// can be compared.
+		uint64_t checksum = 0;
+		uint64_t masks[6];
+		Time t1(boost::posix_time::microsec_clock::local_time());
+		for (const BasicItem<T>& item : items)
+			for (size_t first = 0; first < store.size();
+					first += FreeCuboidStoreBase::maskBlock)
+			{
+				store.fitMasks(first, min(FreeCuboidStoreBase::maskBlock,
+						store.size() - first), item.width, item.height,
+						item.depth, masks);
+				for (int o = 0; o < 6; ++o)
+					checksum = checksum * 31 + masks[o];
+			}
+		Time t2(boost::posix_time::microsec_clock::local_time());
+		long usec = (t2 - t1).total_microseconds();
+
+		bool identical = true;
+		if (kernel == FreeCuboidStoreBase::FitKernelScalar)
+		{
+			scalarUsec = usec;
+			scalarChecksum = checksum;
+		}
+		else
+			identical = checksum == scalarChecksum;
+
+		cout << name << ": " << usec / 1000.0 << " ms, " << store.size()
+			<< " free cuboids";
+		if (usec > 0)
+			cout << ", " << tests / usec << " M tests/s";
+		if (kernel != FreeCuboidStoreBase::FitKernelScalar && usec > 0)
+			cout << " (speedup " << double(scalarUsec) / usec << ")";
+		cout << (identical ? "" : " DIFFERENT MASKS") << endl;
+	}
+}
+
+/**
+ * Compare the fit kernels used by the guillotine algorithm, when it scans
+ * all free cuboids, for every coordinate type the cuboids fit.
+ */
+void fitKernelBenchmark(int binWidth, int binDepth, const vector<string>& files)
+{
+	for (const string& file : files)
+	{
+		vector<Cuboid> cuboids = loadCuboids(file.c_str());
+		sort(cuboids.begin(), cuboids.end(), &Cuboid::compareMaxEdge);
+
+		fitMasksBenchmark<float>(file, "float", binWidth, binDepth, cuboids);
+		if (fitsCoordinates<int32_t>(binWidth, binDepth, cuboids))
+			fitMasksBenchmark<int32_t>(file, "int32", binWidth, binDepth, cuboids);
+		if (fitsCoordinates<int16_t>(binWidth, binDepth, cuboids))
+			fitMasksBenchmark<int16_t>(file, "int16", binWidth, binDepth, cuboids);
+	}
+}
+
+/**
+ * Run the global guillotine branch and bound on 1, 2, 4, ... threads (up to
+ * the number of hardware threads) and report the speedup against one thread.
+ * Every run has to give the same placements.
+ */
+void globalBenchmark(const vector<string>& files)
+{
+	unsigned maxThreads = max(1u, thread::hardware_concurrency());
+	vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	for (const string& file : files)
+	{
+		vector<Cuboid> cuboids = loadCuboidsFromXml(file.c_str());
+		vector<Item> items(cuboids.begin(), cuboids.end());
+
+		long serialMsec = 0;
+		vector<Placement> serialPlacements;
+		for (unsigned threads : threadCounts)
+		{
+			Guillotine3d guillotineAlg(300, 250);
+			GlobalSearch search(guillotineAlg, Guillotine3d::CuboidMinHeight,
+					Guillotine3d::SplitLongerLeftoverAxis);
+
+			Time t1(boost::posix_time::microsec_clock::local_time());
+			guillotineAlg = search.branchAndBound(items, 0, threads);
+			Time t2(boost::posix_time::microsec_clock::local_time());
+			long msec = (t2 - t1).total_milliseconds();
+
+			bool identical = true;
+			if (threads == 1)
+			{
+				serialMsec = msec;
+				serialPlacements = guillotineAlg.getPlacements();
+			}
+			else
+				identical = guillotineAlg.getPlacements() == serialPlacements;
+
+			cout << file << " threads: " << threads << ": " << msec << " ms, height "
+				<< guillotineAlg.getFilledBinHeight();
+			if (threads > 1 && msec > 0)
+				cout << " (speedup " << double(serialMsec) / msec << ")";
+			cout << (identical ? "" : " DIFFERENT PLACEMENTS") << endl;
+		}
+	}
+}
+
+/**
+ * Compare the shelf algorithm building shelves of height classes in parallel
+ * with the serial one: bin height and time.
+ */
+void shelfBenchmark(const vector<string>& files)
+{
+	unsigned maxThreads = max(1u, thread::hardware_concurrency());
+
+	for (const string& file : files)
+	{
+		vector<Cuboid> cuboids = loadCuboidsFromXml(file.c_str());
+		sort(cuboids.begin(), cuboids.end(), &Cuboid::compareVolume);
+
+		ShelfAlgorithm serialAlg(300, 250);
+		Time t1(boost::posix_time::microsec_clock::local_time());
+		serialAlg.insert(cuboids, ShelfAlgorithm::ShelfFirstFit);
+		Time t2(boost::posix_time::microsec_clock::local_time());
+		long serialMsec = (t2 - t1).total_milliseconds();
+		float serialHeight = serialAlg.getFilledBinHeight();
+		cout << file << " serial: height " << serialHeight << ", "
+			<< serialMsec << " ms" << endl;
+
+		for (unsigned classes = 2; classes <= 16; classes *= 2)
+		{
+			unsigned threads = min(classes, maxThreads);
+			ShelfAlgorithm shelfAlg(300, 250);
+			t1 = boost::posix_time::microsec_clock::local_time();
+			shelfAlg.insertParallel(cuboids, ShelfAlgorithm::ShelfFirstFit, classes, threads);
+			t2 = boost::posix_time::microsec_clock::local_time();
+			long msec = (t2 - t1).total_milliseconds();
+			float height = shelfAlg.getFilledBinHeight();
+
+			cout << file << " " << classes << " classes, " << threads << " threads: height "
+				<< height << " (" << showpos << 100 * (height - serialHeight) / serialHeight
+				<< noshowpos << "%), " << msec << " ms";
+			if (msec > 0)
+				cout << " (speedup " << double(serialMsec) / msec << ")";
+			cout << endl;
+		}
+	}
+}
+
+/**
+ * Compare CuboidXmlParser with the Boost xml archive used before: throughput
+ * in MB/s of the file and equality of loaded cuboids. Parsed cuboids are
+ * also converted to a temporary columnar file, whose load is timed and
+ * compared the same way.
+ */
+void parseBenchmark(const vector<string>& files)
+{
+	for (const string& file : files)
+	{
+		// The parser goes first, the archive does not report malformed files.
+		Time t1(boost::posix_time::microsec_clock::local_time());
+		CuboidXmlParser parser;
+		vector<Cuboid> parsedCuboids;
+		bool parsed = parser.open(file.c_str()) && parser.parse(parsedCuboids);
+		Time t2(boost::posix_time::microsec_clock::local_time());
+		long parserUsec = (t2 - t1).total_microseconds();
+		if (!parsed)
+		{
+			cout << file << ": " << parser.getError() << endl;
+			continue;
+		}
+
+		t1 = boost::posix_time::microsec_clock::local_time();
+		vector<Cuboid> archiveCuboids;
+		try
+		{
+			archiveCuboids = loadCuboidsFromXmlArchive(file.c_str());
+		}
+		catch (const exception& e)
+		{
+			cout << file << ": boost: " << e.what() << endl;
+			continue;
+		}
+		t2 = boost::posix_time::microsec_clock::local_time();
+		long archiveUsec = (t2 - t1).total_microseconds();
+
+		bool identical = archiveCuboids.size() == parsedCuboids.size();
+		for (size_t i = 0; identical && i < parsedCuboids.size(); ++i)
+		{
+			const Cuboid& a = archiveCuboids[i];
+			const Cuboid& b = parsedCuboids[i];
+			identical = a.width == b.width && a.height == b.height && a.depth == b.depth &&
+					a.x == b.x && a.y == b.y && a.z == b.z && a.id == b.id && a.container == b.container;
+		}
+
+		// Columnar file of the same cuboids, sizes and ids only
+		string columnarName = (std::filesystem::temp_directory_path() /
+				"parse_benchmark.bpc").string();
+		if (!saveItemsColumnar(parsedCuboids, columnarName.c_str()))
+		{
+			cout << file << ": can not write " << columnarName << endl;
+			continue;
+		}
+		t1 = boost::posix_time::microsec_clock::local_time();
+		ColumnarFile columnar;
+		vector<Cuboid> columnarCuboids;
+		if (columnar.open(columnarName.c_str()))
+			columnar.loadItems(columnarCuboids);
+		t2 = boost::posix_time::microsec_clock::local_time();
+		long columnarUsec = (t2 - t1).total_microseconds();
+		std::filesystem::remove(columnarName);
+
+		identical = identical && columnarCuboids.size() == parsedCuboids.size();
+		for (size_t i = 0; identical && i < parsedCuboids.size(); ++i)
+		{
+			const Cuboid& a = columnarCuboids[i];
+			const Cuboid& b = parsedCuboids[i];
+			identical = a.width == b.width && a.height == b.height && a.depth == b.depth &&
+					a.id == b.id;
+		}
+
+		double megabytes = parser.size() / 1e6;
+		cout << file << " " << megabytes << " MB, " << parsedCuboids.size() << " cuboids: boost "
+			<< megabytes / max(archiveUsec, 1L) * 1e6 << " MB/s, parser "
+			<< megabytes / max(parserUsec, 1L) * 1e6 << " MB/s (speedup "
+			<< double(archiveUsec) / max(parserUsec, 1L) << "), columnar "
+			<< columnarUsec << " us (speedup over parser "
+			<< double(parserUsec) / max(columnarUsec, 1L) << ")"
+			<< (identical ? "" : " DIFFERENT CUBOIDS") << endl;
+	}
+}
+
+/**
+ * Parse CSV or JSON lines files on 1, 2, 4, ... threads (up to the number of
+ * hardware threads) and report throughput in MB/s and the speedup against
+ * one thread. Every run has to give the same cuboids.
+ */
+void ingestBenchmark(const vector<string>& files)
+{
+	unsigned maxThreads = max(1u, thread::hardware_concurrency());
+	vector<unsigned> threadCounts;
+	for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+		threadCounts.push_back(threads);
+	threadCounts.push_back(maxThreads);
+
+	for (const string& file : files)
+	{
+		CuboidTextParser::Format format;
+		CuboidTextParser parser;
+		if (!CuboidTextParser::formatOf(file.c_str(), &format))
+		{
+			cout << file << ": not a .csv, .jsonl or .ndjson file" << endl;
+			continue;
+		}
+		if (!parser.open(file.c_str()))
+		{
+			cout << file << ": " << parser.getError() << endl;
+			continue;
+		}
+
+		long serialUsec = 0;
+		vector<Cuboid> serialCuboids;
+		for (unsigned threads : threadCounts)
+		{
+			vector<Cuboid> cuboids;
+			Time t1(boost::posix_time::microsec_clock::local_time());
+			bool parsed = parser.parse(format, cuboids, threads);
+			Time t2(boost::posix_time::microsec_clock::local_time());
+			long usec = max((t2 - t1).total_microseconds(), 1L);
+			if (!parsed)
+			{
+				cout << file << ": " << parser.getError() << endl;
+				break;
+			}
+
+			bool identical = true;
+			if (threads == 1)
+			{
+				serialUsec = usec;
+				serialCuboids.swap(cuboids);
+			}
+			else
+			{
+				identical = cuboids.size() == serialCuboids.size();
+				for (size_t i = 0; identical && i < cuboids.size(); ++i)
+					identical = cuboids[i].width == serialCuboids[i].width &&
+							cuboids[i].height == serialCuboids[i].height &&
+							cuboids[i].depth == serialCuboids[i].depth &&
+							cuboids[i].id == serialCuboids[i].id;
+			}
+
+			cout << file << " threads: " << threads << ": " << serialCuboids.size()
+				<< " cuboids, " << parser.size() / 1e6 / usec * 1e6 << " MB/s";
+			if (threads > 1)
+				cout << " (speedup " << double(serialUsec) / usec << ")";
+			cout << (identical ? "" : " DIFFERENT CUBOIDS") << endl;
+		}
+	}
+}
+
+/**
+ * Input and output file of a job of the batch mode, with the time it took
+ * to load, pack and save the cuboids.
+ */
+struct BatchJob
+{
+	string inFile;
+	string outFile;
+	long usec;
+	bool failed;
+};
+
+/**
+ * Read jobs of the batch mode: lines "in_file out_file" of a manifest, or
+ * every xml or columnar file of a directory saved under the same name in
+ * outDir.
+ * @return false if the source or outDir can not be read, or if a job would
+ * overwrite its input file.
+ */
+bool readBatchJobs(const string& source, const string& outDir, vector<BatchJob>& jobs)
+{
+	namespace fs = std::filesystem;
+	if (fs::is_directory(source))
+	{
+		if (outDir.empty() || !fs::is_directory(outDir))
+		{
+			cerr << "Batch of a directory needs an existing output directory." << endl;
+			return false;
+		}
+		if (fs::equivalent(source, outDir))
+		{
+			cerr << "The output directory of a batch has to differ from the input one." << endl;
+			return false;
+		}
+		for (const fs::directory_entry& entry : fs::directory_iterator(source))
+			if (entry.is_regular_file() && (entry.path().extension() == ".xml" ||
+					entry.path().extension() == ".bpc"))
+				jobs.push_back({entry.path().string(),
+						(fs::path(outDir) / entry.path().filename()).string(), 0, false});
+		// Directory order is unspecified
+		sort(jobs.begin(), jobs.end(), [](const BatchJob& a, const BatchJob& b)
+				{ return a.inFile < b.inFile; });
+		return true;
+	}
+
+	ifstream manifest(source);
+	if (!manifest.good())
+	{
+		cerr << "Can not read " << source << endl;
+		return false;
+	}
+	string line;
+	while (getline(manifest, line))
+	{
+		istringstream fields(line);
+		BatchJob job = {"", "", 0, false};
+		if (!(fields >> job.inFile) || job.inFile[0] == '#')
+			continue;
+		if (!(fields >> job.outFile))
+		{
+			cerr << "No output file for " << job.inFile << " in " << source << endl;
+			return false;
+		}
+		error_code error;
+		if (fs::equivalent(job.inFile, job.outFile, error))
+		{
+			cerr << "The output file of " << job.inFile << " is its input file." << endl;
+			return false;
+		}
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+/**
+ * Run jobs of the batch mode taken from the counter next, with one packer
+ * reused for all of them. The output is written to a temporary file next to
+ * the output file and renamed over it, so a failed job keeps the previous
+ * output.
+ */
+void runBatchJobs(int binWidth, int binDepth, bool shelf, vector<BatchJob>& jobs, atomic<size_t>& next)
+{
+	unique_ptr<Packer> packer = Packer::create(shelf ? Packer::EngineShelf : Packer::EngineGuillotine,
+			binWidth, binDepth);
+	Rect base(binWidth, binDepth);
+	string tmpFile;
+
+	for (size_t i = next++; i < jobs.size(); i = next++)
+	{
+		BatchJob& job = jobs[i];
+		Time t1(boost::posix_time::microsec_clock::local_time());
+		try
+		{
+			if (!ifstream(job.inFile).good())
+				throw runtime_error("can not read the input file");
+			// Jobs run on threads already, one thread parses a text file.
+			vector<Cuboid> cuboids = loadCuboids(job.inFile.c_str(), 1);
+
+			packer->pack(cuboids);
+
+			// The temporary file keeps the extension, which selects the format.
+			namespace fs = std::filesystem;
+			fs::path outPath(job.outFile);
+			tmpFile = (outPath.parent_path() / ("." + outPath.stem().string() +
+					".partial" + outPath.extension().string())).string();
+			if (!ofstream(tmpFile).good())
+				throw runtime_error("can not write the output file");
+			savePlacedCuboids(packer->getPlacedCuboids(), cuboids, base, tmpFile.c_str());
+			fs::rename(tmpFile, job.outFile);
+			tmpFile.clear();
+		}
+		catch (const exception& e)
+		{
+			job.failed = true;
+			cerr << job.inFile << ": " << e.what() << endl;
+			if (!tmpFile.empty())
+			{
+				error_code error;
+				std::filesystem::remove(tmpFile, error);
+				tmpFile.clear();
+			}
+		}
+		Time t2(boost::posix_time::microsec_clock::local_time());
+		job.usec = (t2 - t1).total_microseconds();
+	}
+}
+
+/**
+ * Pack independent jobs of a manifest or a directory on threads and report
+ * the throughput and percentiles of the time of a job.
+ */
+int batchAlgorithm(int binWidth, int binDepth, bool shelf, const string& source, const string& outDir,
+		unsigned threads)
+{
+	vector<BatchJob> jobs;
+	if (!readBatchJobs(source, outDir, jobs))
+		return 1;
+
+	Time t1(boost::posix_time::microsec_clock::local_time());
+	atomic<size_t> next(0);
+	vector<thread> workers;
+	for (unsigned t = 0; t < threads; ++t)
+		workers.push_back(thread(runBatchJobs, binWidth, binDepth, shelf, ref(jobs), ref(next)));
+	for (thread& t : workers)
+		t.join();
+	Time t2(boost::posix_time::microsec_clock::local_time());
+	long msec = (t2 - t1).total_milliseconds();
+
+	size_t failed = 0;
+	vector<long> latencies;
+	for (const BatchJob& job : jobs)
+	{
+		if (job.failed)
+			++failed;
+		latencies.push_back(job.usec);
+	}
+	sort(latencies.begin(), latencies.end());
+
+	cout << "Jobs: " << jobs.size() << ", failed: " << failed << ", threads: " << threads << endl;
+	cout << "It took me: " << msec << endl;
+	if (msec > 0)
+		cout << "Jobs per second: " << 1000.0 * jobs.size() / msec << endl;
+	if (!latencies.empty())
+	{
+		cout << "Job latency [ms]:";
+		const pair<const char*, double> percentiles[] = {
+			{"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"max", 1.0}
+		};
+		for (const auto& p : percentiles)
+		{
+			size_t rank = min(latencies.size() - 1, size_t(p.second * (latencies.size() - 1) + 0.5));
+			cout << " " << p.first << " " << latencies[rank] / 1000.0;
+		}
+		cout << endl;
+	}
+	return failed > 0 ? 1 : 0;
 }
 
 void usage()
 {
-	cout << "Usage: 3dBinPacking [-shelf | -guillotine | -global_guillotine] width depth [-f in_file | -r arg arg] -o out_file [-t]" << endl<<endl;
+	cout << "Usage: 3dBinPacking [-shelf | -guillotine | -global_guillotine | -portfolio] width depth [-f in_file | -r arg arg] -o out_file [-t] [-compact] [-beam n] [-nodes n] [-threads n]" << endl;
+	cout << "\t[-choice heuristic] [-coordinates type] [-stream] [-height h] [-render render_file]" << endl<<endl;
 	cout << "Options:" << endl;
 	cout << "-shelf \t\t: Shelf algorithm + guillotine algorithm (with initial cuboids sorting)" << endl;
 	cout << "-guillotine \t: Guillotine algorithm (with initial cuboids sorting)"<< endl;
-	cout << "-global_guillotine: Global guillotine algorithm (without initial sorting)" << endl<<endl;
+	cout << "-global_guillotine: Global guillotine algorithm (without initial sorting)" << endl;
+	cout << "\t\t  Branch and bound over orders of cuboids, or beam search with -beam." << endl;
+	cout << "-portfolio \t: Every combination of algorithm (shelf with every shelf choice but" << endl;
+	cout << "\t\t  next_fit, guillotine), sort key and split heuristic on its own thread," << endl;
+	cout << "\t\t  the lowest packing is saved." << endl<<endl;
 	cout << "width, depth\t: Size of a cuboid base."<< endl;
 	cout << "-f \t: Input xml file with information about cuboids to put." << endl;
 	cout << "-r \t: Generate n random cuboids, with parameter:" << endl;
@@ -224,11 +904,61 @@ void usage()
 	cout << "\t\t 2 - two edges have the same length" << endl;
 	cout << "\t\t 3 - three edges have the same length" << endl;
 	cout << "-o \t: Output file which will store information about placed cuboids." << endl;
-	cout << "-t \t: Time measurement enabled." << endl << endl;
+	cout << "-t \t: Time measurement enabled." << endl;
+	cout << "-compact: Compaction of free cuboids (guillotine algorithms) or merging of free rectangles of shelves (shelf algorithm)." << endl;
+	cout << "-beam \t: Beam search keeping n best partial orders (global guillotine only)." << endl;
+	cout << "-nodes \t: Partial orders visited by branch and bound at most, 0 for an exact" << endl;
+	cout << "\t\t  search (global guillotine only, " << defaultNodeLimit << " by default)." << endl;
+	cout << "-threads: Number of threads of branch and bound (global guillotine), or of height" << endl;
+	cout << "\t\t  classes of shelves built in parallel (shelf)." << endl;
+	cout << "-choice \t: Choice of a free cuboid (guillotine algorithms):" << endl;
+	cout << "\t\t min_height (default), best_volume, best_short_side, contact_area" << endl;
+	cout << "\t\t  or of a shelf (shelf algorithm):" << endl;
+	cout << "\t\t first_fit (default), next_fit, best_height, best_area, worst_area" << endl;
+	cout << "-coordinates: Coordinate type of the guillotine algorithm (-guillotine only):" << endl;
+	cout << "\t\t float (default), int32, int16 (whole sizes only)" << endl;
+	cout << "-stream\t: Save cuboids of every shelf as soon as the shelf is closed (-shelf only)." << endl;
+	cout << "-height\t: Height of containers; new containers are opened on demand and every" << endl;
+	cout << "\t\t  cuboid records its container (-shelf only)." << endl;
+	cout << "-render\t: Save also a little-endian float32 buffer of centers and sizes of placed" << endl;
+	cout << "\t\t  cuboids for visual/app/cuboids.html (not with -stream); containers of" << endl;
+	cout << "\t\t  -height are stacked." << endl << endl;
 
 	cout << "Generating only cuboids is available." << endl;
 	cout << "Usage: 3dBinPacking -r number_of_cuboids parameter -o out_file" << endl<<endl;
 
+	cout << "Files ending with .bpc are binary columnar files, others are xml files." << endl;
+	cout << "Input cuboids are also read from .csv and .jsonl (or .ndjson) files, with" << endl;
+	cout << "width, height and depth of a cuboid per line." << endl;
+	cout << "Converting input cuboids between xml and columnar files is available." << endl;
+	cout << "Usage: 3dBinPacking -convert in_file out_file" << endl;
+	cout << "Placements of a columnar output file are converted with the input cuboids" << endl;
+	cout << "they were packed from, e.g. to an xml file for the viewer." << endl;
+	cout << "Usage: 3dBinPacking -convert placements.bpc in_file out_file" << endl<<endl;
+
+	cout << "Benchmark of fit kernels of the guillotine algorithm on the free cuboids of a" << endl;
+	cout << "packing into a bin with the given base, for every coordinate type." << endl;
+	cout << "Usage: 3dBinPacking -fit_benchmark width depth in_file..." << endl<<endl;
+
+	cout << "Benchmark of threads of the global guillotine algorithm." << endl;
+	cout << "Usage: 3dBinPacking -global_benchmark in_file..." << endl<<endl;
+
+	cout << "Benchmark of shelves of height classes built in parallel." << endl;
+	cout << "Usage: 3dBinPacking -shelf_benchmark in_file..." << endl<<endl;
+
+	cout << "Throughput of loading xml files of cuboids: Boost archive against the parser," << endl;
+	cout << "and time of loading the same cuboids from a columnar file." << endl;
+	cout << "Usage: 3dBinPacking -parse_benchmark in_file..." << endl<<endl;
+
+	cout << "Throughput of parsing CSV or JSON lines files of cuboids on threads." << endl;
+	cout << "Usage: 3dBinPacking -ingest_benchmark in_file..." << endl<<endl;
+
+	cout << "Batch of jobs packed on threads, with one packer per thread. A manifest holds" << endl;
+	cout << "lines \"in_file out_file\"; xml and columnar files of a directory are saved" << endl;
+	cout << "into out_dir." << endl;
+	cout << "Usage: 3dBinPacking -batch [-shelf | -guillotine] width depth (manifest | directory)" << endl;
+	cout << "\t[-threads n] [-o out_dir]" << endl<<endl;
+
 	cout << "Example:" << endl;
 	cout << "./3dBinPacking -shelf 300 250 -f input_file.xml -o output_file.xml -t" << endl;
 	cout << "./3dBinPacking -shelf 300 250 -r 1000 2 -o output_file.xml -t" << endl;
@@ -241,6 +971,105 @@ int main(int argc, char* argv[])
 	// Set seed
 	srand (time(NULL));
 
+	// Benchmark fit kernels only
+	if (argc > 4 && string(argv[1]) == "-fit_benchmark")
+	{
+		int width = atoi(argv[2]);
+		int depth = atoi(argv[3]);
+		if (width <= 0 || depth <= 0)
+		{
+			usage();
+			return 1;
+		}
+		fitKernelBenchmark(width, depth, vector<string>(argv + 4, argv + argc));
+		return 0;
+	}
+
+	// Benchmark threads of the global guillotine algorithm only
+	if (argc > 2 && string(argv[1]) == "-global_benchmark")
+	{
+		globalBenchmark(vector<string>(argv + 2, argv + argc));
+		return 0;
+	}
+
+	// Benchmark shelves built in parallel only
+	if (argc > 2 && string(argv[1]) == "-shelf_benchmark")
+	{
+		shelfBenchmark(vector<string>(argv + 2, argv + argc));
+		return 0;
+	}
+
+	// Benchmark loading cuboids only
+	if (argc > 2 && string(argv[1]) == "-parse_benchmark")
+	{
+		parseBenchmark(vector<string>(argv + 2, argv + argc));
+		return 0;
+	}
+
+	// Benchmark parsing text files only
+	if (argc > 2 && string(argv[1]) == "-ingest_benchmark")
+	{
+		ingestBenchmark(vector<string>(argv + 2, argv + argc));
+		return 0;
+	}
+
+	// Batch of jobs only
+	if (argc > 5 && string(argv[1]) == "-batch")
+	{
+		string algorithm = argv[2];
+		int width = atoi(argv[3]);
+		int depth = atoi(argv[4]);
+		string outDir = "";
+		unsigned threads = max(1u, thread::hardware_concurrency());
+		for (int i = 6; i + 1 < argc; ++i)
+		{
+			string arg = argv[i];
+			if (arg == "-threads")
+				threads = max(1, atoi(argv[i + 1]));
+			if (arg == "-o")
+				outDir = argv[i + 1];
+		}
+		if ((algorithm != "-shelf" && algorithm != "-guillotine") || width <= 0 || depth <= 0)
+		{
+			usage();
+			return 1;
+		}
+		return batchAlgorithm(width, depth, algorithm == "-shelf", argv[5], outDir, threads);
+	}
+
+	// Convert input cuboids only
+	if (argc == 4 && string(argv[1]) == "-convert")
+	{
+		try
+		{
+			saveCuboids(loadCuboids(argv[2]), argv[3]);
+		}
+		catch (const runtime_error& e)
+		{
+			cerr << e.what() << endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	// Convert placements only
+	if (argc == 5 && string(argv[1]) == "-convert")
+	{
+		try
+		{
+			vector<Cuboid> inputs = loadCuboids(argv[3]);
+			Rect base;
+			vector<Cuboid> placed = loadPlacedCuboids(argv[2], inputs, base);
+			savePlacedCuboids(placed, inputs, base, argv[4]);
+		}
+		catch (const runtime_error& e)
+		{
+			cerr << e.what() << endl;
+			return 1;
+		}
+		return 0;
+	}
+
 	// Generate random cuboids only
 	if (argc == 5)
 	{
@@ -251,21 +1080,31 @@ int main(int argc, char* argv[])
 			int paramRandCuboids = atoi(argv[3]);
 			string outFile = argv[4];
 			vector<Cuboid> cuboids = generateRandomCuboids(numberOfRandCuboids, paramRandCuboids);
-			saveXml(cuboids, Rect(), outFile.c_str());
+			saveCuboids(cuboids, outFile.c_str());
 			return 0;
 		}
 	}
 
-	if (argc < 8 || argc > 10)
+	if (argc < 8 || argc > 26)
 		usage();
 	else
 	{
 		string algorithm = "";
 		string outFile = "";
 		string inFile = "";
+		string renderFile = "";
 		int width = -1;
 		int depth = -1;
 		bool timeMeasurement = false;
+		bool compaction = false;
+		bool streaming = false;
+		unsigned beamWidth = 0;
+		unsigned long nodeLimit = defaultNodeLimit;
+		unsigned threads = 1;
+		int height = 0;
+		Guillotine3d::FreeCuboidChoiceHeuristic cuboidChoice = Guillotine3d::CuboidMinHeight;
+		ShelfAlgorithm::ShelfChoiceHeuristic shelfChoice = ShelfAlgorithm::ShelfFirstFit;
+		string coordinates = "float";
 		bool random = false;
 		int numberOfRandCuboids = -1;
 		int paramRandCuboids = 1;
@@ -274,7 +1113,8 @@ int main(int argc, char* argv[])
 		{
 			string arg = argv[i];
 			// algorithm choice
-			if (arg == "-shelf" || arg == "-guillotine" || arg == "-global_guillotine")
+			if (arg == "-shelf" || arg == "-guillotine" || arg == "-global_guillotine" ||
+				arg == "-portfolio")
 				algorithm = arg;
 
 			if (i == 2)
@@ -295,8 +1135,48 @@ int main(int argc, char* argv[])
 			if (arg == "-o")
 				outFile = argv[i + 1];
 
+			if (arg == "-render" && i + 1 < argc)
+				renderFile = argv[i + 1];
+
 			if (arg == "-t")
 				timeMeasurement = true;
+
+			if (arg == "-compact")
+				compaction = true;
+
+			if (arg == "-stream")
+				streaming = true;
+
+			if (arg == "-beam")
+				beamWidth = atoi(argv[i + 1]);
+
+			if (arg == "-nodes" && i + 1 < argc)
+				nodeLimit = strtoul(argv[i + 1], 0, 10);
+
+			if (arg == "-threads")
+				threads = atoi(argv[i + 1]);
+
+			if (arg == "-height")
+				height = atoi(argv[i + 1]);
+
+			if (arg == "-choice" && (i + 1 == argc || (algorithm == "-shelf" ?
+					!parseShelfChoice(argv[i + 1], &shelfChoice) :
+					!parseCuboidChoice(argv[i + 1], &cuboidChoice))))
+			{
+				usage();
+				return 1;
+			}
+
+			if (arg == "-coordinates")
+			{
+				if (i + 1 < argc)
+					coordinates = argv[i + 1];
+				if (coordinates != "float" && coordinates != "int32" && coordinates != "int16")
+				{
+					usage();
+					return 1;
+				}
+			}
 		}
 
 		if (algorithm.empty() || outFile.empty() || width == -1 || depth == -1)
@@ -304,6 +1184,16 @@ int main(int argc, char* argv[])
 			usage();
 			return 1;
 		}
+		if (height > 0 && (algorithm != "-shelf" || streaming || threads > 1))
+		{
+			cerr << "Containers of a finite height are packed by -shelf only, without -stream and -threads." << endl;
+			return 1;
+		}
+		if (streaming && (isColumnarFile(outFile.c_str()) || !renderFile.empty()))
+		{
+			cerr << "Streamed shelves are saved to xml files only, without -render." << endl;
+			return 1;
+		}
 		if (inFile.empty())
 		{
 			if (random == false)
@@ -323,15 +1213,52 @@ int main(int argc, char* argv[])
 		if (random)
 			cuboids = generateRandomCuboids(numberOfRandCuboids, paramRandCuboids);
 		else
-			cuboids = loadCuboidsFromXml(inFile.c_str());
+		{
+			try
+			{
+				cuboids = loadCuboids(inFile.c_str());
+			}
+			catch (const runtime_error& e)
+			{
+				cerr << e.what() << endl;
+				return 1;
+			}
+		}
+
 
+		Packer::Options options;
+		options.compaction = compaction;
+		options.shelfChoice = shelfChoice;
+		options.cuboidChoice = cuboidChoice;
+		options.threads = threads;
+		options.beamWidth = beamWidth;
+		options.nodeLimit = nodeLimit;
+		if (coordinates == "int32")
+			options.coordinates = Packer::CoordinatesInt32;
+		else if (coordinates == "int16")
+			options.coordinates = Packer::CoordinatesInt16;
 
-		if (algorithm == "-shelf")
-			shelfAlgorithm(width, depth, cuboids, outFile, timeMeasurement);
+		if (algorithm == "-shelf" && height > 0)
+			containerAlgorithm(width, depth, height, cuboids, outFile, renderFile, timeMeasurement, compaction, shelfChoice);
+		else if (algorithm == "-shelf" && streaming)
+			shelfStreamingAlgorithm(width, depth, cuboids, outFile, timeMeasurement, compaction, shelfChoice);
+		else if (algorithm == "-shelf")
+			packerAlgorithm(Packer::EngineShelf, width, depth, cuboids, outFile, renderFile, timeMeasurement, options);
 		else if (algorithm == "-guillotine")
-			guillotineAlgorithm(width, depth, cuboids, outFile, timeMeasurement);
+		{
+			if ((coordinates == "int32" && !fitsCoordinates<int32_t>(width, depth, cuboids)) ||
+				(coordinates == "int16" && !fitsCoordinates<int16_t>(width, depth, cuboids)))
+			{
+				cerr << "Cuboids do not fit " << coordinates << " coordinates." << endl;
+				return 1;
+			}
+			packerAlgorithm(Packer::EngineGuillotine, width, depth, cuboids, outFile, renderFile, timeMeasurement, options);
+		}
 		else if (algorithm == "-global_guillotine")
-			guillotineGlobalAlgorithm(width, depth, cuboids, outFile, timeMeasurement);
+			packerAlgorithm(Packer::EngineGlobalGuillotine, width, depth, cuboids, outFile, renderFile,
+					timeMeasurement, options);
+		else if (algorithm == "-portfolio")
+			portfolioAlgorithm(width, depth, cuboids, outFile, renderFile, timeMeasurement);
 	}
 
 	return 0;
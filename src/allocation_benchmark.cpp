@@ -0,0 +1,126 @@
+//============================================================================
+// Name        : allocation_benchmark.cpp
+// Author      : krris
+// Version     : 1.0
+// Description : Program which counts heap allocations of packing cuboids
+//               again with algorithms and packers used before. It links
+//               the allocation counter, which the 3dBinPacking program
+//               does not.
+//============================================================================
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "../include/allocation_counter.hpp"
+#include "../include/cuboid.hpp"
+#include "../include/cuboid_io.hpp"
+#include "../include/guillotine3d.hpp"
+#include "../include/item.hpp"
+#include "../include/packer.hpp"
+#include "../include/shelf_algorithm.hpp"
+
+using namespace std;
+
+/* Print the allocations of a packing. @return false if the packing should
+ * not have allocated but did. */
+static bool report(const string& file, const string& name,
+		unsigned long allocations, size_t cuboids, bool steady)
+{
+	cout << file << " " << name << ": " << allocations << " allocations, "
+		<< double(allocations) / cuboids << " per insert";
+	if (steady && allocations != 0)
+	{
+		cout << " FAILED" << endl;
+		return false;
+	}
+	cout << endl;
+	return true;
+}
+
+/**
+ * Count heap allocations of packing cuboids again, after a first packing
+ * has grown the containers of the algorithm. Shelves are allocated from
+ * the heap and from a pool kept between packings; all but shelves from the
+ * heap must not allocate.
+ * @return false if a packing which must not allocate did.
+ */
+static bool allocationBenchmark(const string& file)
+{
+	vector<Cuboid> cuboids = loadCuboidsFromXml(file.c_str());
+	vector<Cuboid> byVolume = cuboids;
+	sort(byVolume.begin(), byVolume.end(), &Cuboid::compareVolume);
+	vector<Cuboid> byMaxEdge = cuboids;
+	sort(byMaxEdge.begin(), byMaxEdge.end(), &Cuboid::compareMaxEdge);
+	vector<Item> items(byMaxEdge.begin(), byMaxEdge.end());
+	bool ok = true;
+
+	for (bool pool : {false, true})
+	{
+		std::pmr::unsynchronized_pool_resource poolResource;
+		ShelfAlgorithm shelfAlg(300, 250, pool ? &poolResource :
+				std::pmr::get_default_resource());
+		unsigned long allocations = 0;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			shelfAlg.init(300, 250);
+			unsigned long before = allocationCount();
+			for (const Cuboid& cuboid : byVolume)
+				shelfAlg.insert(cuboid, ShelfAlgorithm::ShelfFirstFit);
+			allocations = allocationCount() - before;
+		}
+		ok &= report(file, pool ? "shelf pool" : "shelf heap", allocations,
+				cuboids.size(), pool);
+	}
+
+	// Free cuboids keep their capacity after init().
+	Guillotine3d guillotineAlg(300, 250);
+	unsigned long allocations = 0;
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		guillotineAlg.init(300, 250);
+		unsigned long before = allocationCount();
+		for (const Item& item : items)
+			guillotineAlg.insert(item, Guillotine3d::CuboidMinHeight,
+					Guillotine3d::SplitLongerLeftoverAxis);
+		allocations = allocationCount() - before;
+	}
+	ok &= report(file, "guillotine", allocations, cuboids.size(), true);
+
+	// Packers keep their memory between jobs, sorting included. The
+	// third packing is counted, containers of the guillotine engine may
+	// still grow during the second one.
+	for (Packer::Engine engine : {Packer::EngineShelf, Packer::EngineGuillotine})
+	{
+		unique_ptr<Packer> packer = Packer::create(engine, 300, 250);
+		for (int pass = 0; pass < 3; ++pass)
+		{
+			unsigned long before = allocationCount();
+			packer->pack(cuboids);
+			allocations = allocationCount() - before;
+		}
+		ok &= report(file, engine == Packer::EngineShelf ?
+				"packer shelf" : "packer guillotine", allocations,
+				cuboids.size(), true);
+	}
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cout << "Heap allocations of inserting into an algorithm used before." << endl;
+		cout << "Exits with 1 if a packing which must not allocate did." << endl;
+		cout << "Usage: allocationBenchmark in_file..." << endl;
+		return 2;
+	}
+
+	bool ok = true;
+	for (int i = 1; i < argc; ++i)
+		ok &= allocationBenchmark(argv[i]);
+	return ok ? 0 : 1;
+}
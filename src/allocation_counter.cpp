@@ -0,0 +1,91 @@
+//============================================================================
+// Name        : allocation_counter.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "../include/allocation_counter.hpp"
+
+// Replacements of the global operator new and delete, counting allocations.
+// Aligned forms are replaced too, std::pmr::new_delete_resource() uses them.
+// Other forms of new and delete of the standard library forward to these.
+
+static std::atomic<unsigned long> allocations(0);
+
+unsigned long allocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	// The size passed to aligned_alloc has to be a multiple of alignment.
+	std::size_t align = static_cast<std::size_t>(alignment);
+	std::size_t alignedSize = (size + align - 1) / align * align;
+	if (void* p = std::aligned_alloc(align, alignedSize == 0 ? align : alignedSize))
+		return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return ::operator new(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+	std::free(p);
+}
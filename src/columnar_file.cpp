@@ -0,0 +1,232 @@
+//============================================================================
+// Name        : columnar_file.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <cstring>
+#include <fstream>
+
+#include "../include/columnar_file.hpp"
+#include "../include/item.hpp"
+
+using namespace std;
+
+static const char columnarMagic[4] = {'B', 'P', 'C', 'F'};
+
+static_assert(sizeof(ColumnarHeader) == ColumnarHeader::columnAlignment,
+		"columns start right after the header");
+
+/* Sizes of values of columns of items and placements. */
+static const size_t itemColumns[] = {sizeof(float), sizeof(float),
+		sizeof(float)};
+static const size_t placementColumns[] = {sizeof(uint32_t), sizeof(uint8_t),
+		sizeof(uint32_t), sizeof(float), sizeof(float), sizeof(float)};
+
+static size_t alignColumn(size_t bytes)
+{
+	const size_t alignment = ColumnarHeader::columnAlignment;
+	return (bytes + alignment - 1) / alignment * alignment;
+}
+
+/* Bytes of a value of every column together. */
+static size_t valueSize(ColumnarFile::Kind kind)
+{
+	const size_t* sizes = kind == ColumnarFile::KindItems ? itemColumns : placementColumns;
+	int columns = kind == ColumnarFile::KindItems ? 3 : 6;
+	size_t size = 0;
+	for (int i = 0; i < columns; ++i)
+		size += sizes[i];
+	return size;
+}
+
+size_t ColumnarFile::columnOffset(Kind kind, size_t count, int column)
+{
+	const size_t* sizes = kind == KindItems ? itemColumns : placementColumns;
+	size_t offset = sizeof(ColumnarHeader);
+	for (int i = 0; i < column; ++i)
+		offset += alignColumn(sizes[i] * count);
+	return offset;
+}
+
+size_t ColumnarFile::fileSize(Kind kind, size_t count)
+{
+	int columns = kind == KindItems ? 3 : 6;
+	return columnOffset(kind, count, columns);
+}
+
+bool ColumnarFile::open(const char* filename)
+{
+	header = 0;
+	error.clear();
+	if (!file.open(filename))
+	{
+		error = file.getError();
+		return false;
+	}
+
+	const ColumnarHeader* h = reinterpret_cast<const ColumnarHeader*>(file.data());
+	if (file.size() < sizeof(ColumnarHeader) ||
+		memcmp(h->magic, columnarMagic, sizeof(columnarMagic)) != 0)
+		error = "not a columnar file of cuboids";
+	else if (h->byteOrder != ColumnarHeader::byteOrderMark)
+		error = "columnar file of another byte order";
+	else if (h->version != ColumnarHeader::currentVersion)
+		error = "columnar file of version " + to_string(h->version) +
+			", expected " + to_string(ColumnarHeader::currentVersion);
+	else if (h->kind != KindItems && h->kind != KindPlacements)
+		error = "unknown kind of columnar file";
+	// Offsets of a count that can not fit the file could overflow.
+	else if (h->count > (file.size() - sizeof(ColumnarHeader)) /
+			valueSize(Kind(h->kind)) ||
+			file.size() < fileSize(Kind(h->kind), h->count))
+		error = "truncated columnar file";
+	if (!error.empty())
+	{
+		file.close();
+		return false;
+	}
+	header = h;
+	return true;
+}
+
+void ColumnarFile::loadItems(vector<Cuboid>& cuboids) const
+{
+	const float* w = widths();
+	const float* h = heights();
+	const float* d = depths();
+	size_t first = cuboids.size();
+	cuboids.resize(first + size());
+	for (size_t i = 0; i < size(); ++i)
+	{
+		Cuboid& cuboid = cuboids[first + i];
+		cuboid.width = w[i];
+		cuboid.height = h[i];
+		cuboid.depth = d[i];
+		cuboid.id = i;
+	}
+}
+
+bool ColumnarFile::loadPlacements(const vector<Cuboid>& inputs,
+		vector<Cuboid>& placed)
+{
+	error.clear();
+	const uint32_t* id = ids();
+	const uint8_t* orientation = orientations();
+	const uint32_t* container = containers();
+	const float* x = xs();
+	const float* y = ys();
+	const float* z = zs();
+	const size_t first = placed.size();
+	placed.reserve(first + size());
+	for (size_t i = 0; i < size(); ++i)
+	{
+		if (id[i] >= inputs.size())
+			error = "placement " + to_string(i) + ": id " + to_string(id[i]) +
+					" of no input cuboid";
+		else if (orientation[i] >= 6)
+			error = "placement " + to_string(i) + ": unknown orientation " +
+					to_string(orientation[i]);
+		if (!error.empty())
+		{
+			placed.resize(first);
+			return false;
+		}
+		const Item item(inputs[id[i]]);
+		Placement placement = {id[i], orientation[i], x[i], y[i], z[i]};
+		placed.push_back(placement.cuboid(item));
+		placed.back().container = container[i];
+	}
+	return true;
+}
+
+/* Write the header and columns given by pointers to count values. */
+static bool saveColumns(ColumnarFile::Kind kind, size_t count, const Rect& base,
+		const vector<const void*>& columns, const char* filename)
+{
+	ofstream out(filename, ios::binary);
+	if (!out.good())
+		return false;
+
+	ColumnarHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, columnarMagic, sizeof(columnarMagic));
+	header.byteOrder = ColumnarHeader::byteOrderMark;
+	header.version = ColumnarHeader::currentVersion;
+	header.kind = kind;
+	header.count = count;
+	header.baseWidth = base.width;
+	header.baseDepth = base.height;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	const size_t* sizes = kind == ColumnarFile::KindItems ? itemColumns : placementColumns;
+	const char padding[ColumnarHeader::columnAlignment] = {};
+	for (size_t i = 0; i < columns.size(); ++i)
+	{
+		size_t bytes = sizes[i] * count;
+		out.write(static_cast<const char*>(columns[i]), bytes);
+		out.write(padding, alignColumn(bytes) - bytes);
+	}
+	return out.good();
+}
+
+bool saveItemsColumnar(const vector<Cuboid>& cuboids, const char* filename)
+{
+	vector<float> widths, heights, depths;
+	widths.reserve(cuboids.size());
+	heights.reserve(cuboids.size());
+	depths.reserve(cuboids.size());
+	for (const Cuboid& c : cuboids)
+	{
+		widths.push_back(c.width);
+		heights.push_back(c.height);
+		depths.push_back(c.depth);
+	}
+	return saveColumns(ColumnarFile::KindItems, cuboids.size(), Rect(),
+			{widths.data(), heights.data(), depths.data()}, filename);
+}
+
+bool savePlacementsColumnar(const vector<Cuboid>& placed,
+		const vector<Cuboid>& inputs, const Rect& base, const char* filename,
+		string* error)
+{
+	vector<uint32_t> ids, containers;
+	vector<uint8_t> orientations;
+	vector<float> xs, ys, zs;
+	for (const Cuboid& c : placed)
+	{
+		if (c.id >= inputs.size())
+		{
+			if (error)
+				*error = "placed cuboid " + to_string(c.id) +
+						" is not an input cuboid";
+			return false;
+		}
+
+		// The first orientation of the input cuboid with the placed sizes
+		const Item item(inputs[c.id]);
+		uint8_t orientation = 0;
+		while (orientation < 6 &&
+			(item.edge(itemOrientations[orientation][0]) != c.width ||
+			 item.edge(itemOrientations[orientation][1]) != c.height ||
+			 item.edge(itemOrientations[orientation][2]) != c.depth))
+			++orientation;
+		if (orientation == 6)
+		{
+			if (error)
+				*error = "placed cuboid " + to_string(c.id) +
+						" has sizes of no orientation of its input cuboid";
+			return false;
+		}
+
+		ids.push_back(c.id);
+		orientations.push_back(orientation);
+		containers.push_back(c.container);
+		xs.push_back(c.x);
+		ys.push_back(c.y);
+		zs.push_back(c.z);
+	}
+	return saveColumns(ColumnarFile::KindPlacements, placed.size(), base,
+			{ids.data(), orientations.data(), containers.data(), xs.data(),
+			 ys.data(), zs.data()}, filename);
+}
@@ -0,0 +1,96 @@
+//============================================================================
+// Name        : container_packer.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+
+#include "../include/container_packer.hpp"
+
+using namespace std;
+
+ContainerPacker::ContainerPacker(float width, float depth, float height) :
+	width(width), depth(depth), height(height), mergeEnabled(false),
+	placementSink(0)
+{
+	emptyContainer.height = height;
+	emptyContainer.maxShortSide = min(int(width), int(depth));
+	emptyContainer.maxLongSide = max(int(width), int(depth));
+}
+
+Cuboid ContainerPacker::insert(const Cuboid& cuboid,
+		ShelfAlgorithm::ShelfChoiceHeuristic method)
+{
+	float edges[3] = {cuboid.width, cuboid.height, cuboid.depth};
+	sortEdges(edges);
+
+	// Try containers whose shelves or a new shelf may hold the cuboid.
+	size_t leaf = containerIndex.findFirst(0, edges);
+	while (leaf < containerIndex.size())
+	{
+		size_t container = leaf / 2;
+		Cuboid placed = containers[container].insert(cuboid, method);
+		if (placed.isPlaced)
+		{
+			updateIndex(container);
+			placed.container = container;
+			usedCuboids.push_back(placed);
+			if (placementSink)
+				placementSink->place(placed);
+			return placed;
+		}
+		leaf = containerIndex.findFirst(2 * (container + 1), edges);
+	}
+
+	if (!ShelfCapacityIndex::mayHold(emptyContainer, edges))
+		return cuboid;
+
+	openContainer();
+	size_t container = containers.size() - 1;
+	Cuboid placed = containers.back().insert(cuboid, method);
+	if (!placed.isPlaced)
+		return cuboid;
+	updateIndex(container);
+	placed.container = container;
+	usedCuboids.push_back(placed);
+	if (placementSink)
+		placementSink->place(placed);
+	return placed;
+}
+
+size_t ContainerPacker::insert(const vector<Cuboid>& cuboids,
+		ShelfAlgorithm::ShelfChoiceHeuristic method)
+{
+	usedCuboids.reserve(usedCuboids.size() + cuboids.size());
+	size_t notPlaced = 0;
+	for (const Cuboid& cuboid : cuboids)
+		if (!insert(cuboid, method).isPlaced)
+			++notPlaced;
+	return notPlaced;
+}
+
+unsigned long ContainerPacker::getMergeCount() const
+{
+	unsigned long count = 0;
+	for (const ShelfAlgorithm& container : containers)
+		count += container.getMergeCount();
+	return count;
+}
+
+void ContainerPacker::openContainer()
+{
+	containers.emplace_back(width, depth);
+	containers.back().init(width, depth, height);
+	containers.back().setMergeEnabled(mergeEnabled);
+	containerIndex.push_back(containers.back().getShelvesCapacity());
+	containerIndex.push_back(containers.back().getNewShelfCapacity());
+}
+
+void ContainerPacker::updateIndex(size_t container)
+{
+	containerIndex.update(2 * container,
+			containers[container].getShelvesCapacity());
+	containerIndex.update(2 * container + 1,
+			containers[container].getNewShelfCapacity());
+}
@@ -0,0 +1,251 @@
+//============================================================================
+// Name        : cuboid_io.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <boost/serialization/nvp.hpp>
+#include <boost/archive/xml_oarchive.hpp>
+#include <boost/archive/xml_iarchive.hpp>
+
+#include "../include/columnar_file.hpp"
+#include "../include/cuboid_io.hpp"
+#include "../include/cuboid_text_parser.hpp"
+#include "../include/cuboid_xml_parser.hpp"
+
+using namespace std;
+
+void saveXml(const std::vector<Cuboid>& cuboids, const Rect& base, const char* filename)
+{
+    std::ofstream ofs(filename);
+    assert(ofs.good());
+    boost::archive::xml_oarchive oa(ofs);
+
+    for (Cuboid cuboid : cuboids)
+    {
+        oa << boost::serialization::make_nvp("cuboid", cuboid);
+    }
+    if (base.width != 0 && base.height!=0)
+    	oa << boost::serialization::make_nvp("base", base);
+}
+
+std::vector<Cuboid> loadCuboidsFromXml(const char* filename)
+{
+    CuboidXmlParser parser;
+    std::vector<Cuboid> loadedCuboids;
+    if (!parser.open(filename) || !parser.parse(loadedCuboids))
+        throw std::runtime_error(std::string(filename) + ": " + parser.getError());
+    return loadedCuboids;
+}
+
+bool isColumnarFile(const char* filename)
+{
+    const std::string name = filename;
+    const std::string extension = ".bpc";
+    return name.size() >= extension.size() &&
+        name.compare(name.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+std::vector<Cuboid> loadCuboids(const char* filename, unsigned threads)
+{
+    CuboidTextParser::Format format;
+    if (CuboidTextParser::formatOf(filename, &format))
+    {
+        CuboidTextParser parser;
+        std::vector<Cuboid> cuboids;
+        if (!parser.open(filename) || !parser.parse(format, cuboids, threads))
+            throw std::runtime_error(std::string(filename) + ": " + parser.getError());
+        return cuboids;
+    }
+    if (!isColumnarFile(filename))
+        return loadCuboidsFromXml(filename);
+
+    ColumnarFile file;
+    if (!file.open(filename))
+        throw std::runtime_error(std::string(filename) + ": " + file.getError());
+    if (file.kind() != ColumnarFile::KindItems)
+        throw std::runtime_error(std::string(filename) + ": placements, not input cuboids (convert them with their input file)");
+    std::vector<Cuboid> cuboids;
+    file.loadItems(cuboids);
+    return cuboids;
+}
+
+std::vector<Cuboid> loadPlacedCuboids(const char* filename,
+        const std::vector<Cuboid>& inputs, Rect& base)
+{
+    ColumnarFile file;
+    if (!file.open(filename))
+        throw std::runtime_error(std::string(filename) + ": " + file.getError());
+    if (file.kind() != ColumnarFile::KindPlacements)
+        throw std::runtime_error(std::string(filename) + ": input cuboids, not placements");
+    std::vector<Cuboid> placed;
+    if (!file.loadPlacements(inputs, placed))
+        throw std::runtime_error(std::string(filename) + ": " + file.getError());
+    base = file.base();
+    return placed;
+}
+
+void saveCuboids(const std::vector<Cuboid>& cuboids, const char* filename)
+{
+    if (!isColumnarFile(filename))
+        saveXml(cuboids, Rect(), filename);
+    else if (!saveItemsColumnar(cuboids, filename))
+        throw std::runtime_error(std::string("can not write ") + filename);
+}
+
+void savePlacedCuboids(const std::vector<Cuboid>& placed,
+        const std::vector<Cuboid>& inputs, const Rect& base, const char* filename)
+{
+    std::string error;
+    if (!isColumnarFile(filename))
+        saveXml(transform(placed), base, filename);
+    else if (!savePlacementsColumnar(placed, inputs, base, filename, &error))
+        throw std::runtime_error(std::string("can not write ") + filename +
+                (error.empty() ? "" : ": " + error));
+}
+
+void saveRenderBuffer(const std::vector<Cuboid>& placed, const Rect& base,
+        const char* filename, float containerHeight)
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs.good())
+        throw std::runtime_error(std::string("can not write ") + filename);
+
+    // Values are written little-endian whatever the byte order of the
+    // machine.
+    const uint32_t one = 1;
+    const bool swap = *reinterpret_cast<const unsigned char*>(&one) != 1;
+    float values[6];
+    auto write = [&](size_t count)
+    {
+        if (swap)
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &values[i], sizeof(bits));
+                bits = (bits >> 24) | ((bits >> 8) & 0xff00) |
+                    ((bits << 8) & 0xff0000) | (bits << 24);
+                std::memcpy(&values[i], &bits, sizeof(bits));
+            }
+        ofs.write(reinterpret_cast<const char*>(values), count * sizeof(float));
+    };
+
+    values[0] = base.width;
+    values[1] = base.height;
+    write(2);
+    for (const Cuboid& cuboid : placed)
+    {
+        Cuboid c = transform(cuboid);
+        values[0] = c.x;
+        values[1] = c.y + cuboid.container * containerHeight;
+        values[2] = c.z;
+        values[3] = c.width;
+        values[4] = c.height;
+        values[5] = c.depth;
+        write(6);
+    }
+    if (!ofs.good())
+        throw std::runtime_error(std::string("can not write ") + filename);
+}
+
+std::vector<Cuboid> loadCuboidsFromXmlArchive(const char* filename)
+{
+    // Count the stored cuboids first, so that the archive is read exactly to
+    // its end (reading past it leaves the archive in a state in which its
+    // destructor throws).
+    std::ifstream counter(filename);
+    assert(counter.good());
+    std::string line;
+    size_t numberOfCuboids = 0;
+    while (std::getline(counter, line))
+        if (line.find("<cuboid") != std::string::npos)
+            ++numberOfCuboids;
+
+    std::ifstream ifs(filename);
+    assert(ifs.good());
+    boost::archive::xml_iarchive ia(ifs);
+
+    std::vector<Cuboid> loadedCuboids;
+    loadedCuboids.reserve(numberOfCuboids);
+    for (size_t i = 0; i < numberOfCuboids; ++i)
+    {
+        Cuboid cuboid;
+        ia >> boost::serialization::make_nvp("cuboid",cuboid);
+        cuboid.id = i;
+        loadedCuboids.push_back(cuboid);
+    }
+    return loadedCuboids;
+}
+
+/**
+ * Generate random cuboids.
+ * @number Number of cuboids.
+ * @parameter 3 - every edge size is the same
+ * 			  2 - two edges have the same size
+ * 			  1 - every edge size is different.
+ */
+vector<Cuboid> generateRandomCuboids(int number, int parameter)
+{
+	const int maxSize = 100;
+	vector<Cuboid> cuboids;
+	for (int i = 0; i < number; ++i)
+	{
+		int height;
+		int depth;
+		int width = rand() % maxSize + 1;
+		if (parameter == 3)
+		{
+			height = width;
+			depth = width;
+		}
+		else if (parameter == 2)
+		{
+			depth = width;
+			height = rand() % maxSize + 1;
+		}
+		else
+		{
+			height = rand() % maxSize + 1;
+			depth = rand() % maxSize + 1;
+		}
+		Cuboid c(width, height, depth);
+		c.id = i;
+		cuboids.push_back(c);
+	}
+	return cuboids;
+}
+
+
+/**
+ * Transform cuboids before displaying in Three.js
+ */
+vector<Cuboid> transform(const vector<Cuboid>& cuboids)
+{
+	vector<Cuboid> tranformed;
+	tranformed.reserve(cuboids.size());
+	for (const Cuboid& c : cuboids)
+	    tranformed.push_back(transform(c));
+	return tranformed;
+
+}
+
+Cuboid transform(const Cuboid& c)
+{
+	Cuboid newCuboid;
+    newCuboid.x = c.x + (0.5 * c.width);
+    newCuboid.z = c.z + (0.5 * c.depth);
+    newCuboid.y = c.y + 0.5 * c.height;
+    newCuboid.width = c.width;
+    newCuboid.depth = c.depth;
+    newCuboid.height = c.height;
+    newCuboid.id = c.id;
+    newCuboid.container = c.container;
+    return newCuboid;
+}
@@ -0,0 +1,465 @@
+//============================================================================
+// Name        : cuboid_text_parser.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <thread>
+
+#include "../include/cuboid_text_parser.hpp"
+
+using namespace std;
+
+/* Smallest chunk worth a thread of its own. */
+static const size_t minChunkSize = 1 << 20;
+
+/* Chunks of every thread, so threads stay busy if lines differ in length. */
+static const size_t chunksPerThread = 4;
+
+/* Bits of fields of a cuboid found in a line. */
+enum
+{
+	FieldWidth = 1,
+	FieldHeight = 2,
+	FieldDepth = 4,
+	FieldAll = FieldWidth | FieldHeight | FieldDepth
+};
+
+static bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool hasExtension(const string& name, const char* extension)
+{
+	size_t length = strlen(extension);
+	return name.size() >= length &&
+		name.compare(name.size() - length, length, extension) == 0;
+}
+
+static const char* skipSpaces(const char* p, const char* end)
+{
+	while (p < end && isSpace(*p))
+		++p;
+	return p;
+}
+
+/* Field without surrounding spaces and quotes. */
+static void trimField(const char*& begin, const char*& end)
+{
+	begin = skipSpaces(begin, end);
+	while (end > begin && isSpace(end[-1]))
+		--end;
+	if (end - begin >= 2 && *begin == '"' && end[-1] == '"')
+	{
+		++begin;
+		--end;
+	}
+}
+
+/* Sizes of cuboids are finite and positive, unlike everything from_chars
+ * reads: negative numbers, zero, nan and inf. */
+static bool isSize(float value)
+{
+	return value > 0 && isfinite(value);
+}
+
+static bool isBlank(const char* begin, const char* end)
+{
+	return skipSpaces(begin, end) == end;
+}
+
+static const char* lineEnd(const char* p, const char* end)
+{
+	const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+	return eol ? eol : end;
+}
+
+/* Run work(i) for i in [0, count) on threads, each taking the next i. */
+template <class Work>
+static void runOnThreads(size_t count, unsigned threads, const Work& work)
+{
+	atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		for (size_t i; (i = next++) < count;)
+			work(i);
+	};
+	vector<thread> pool;
+	for (unsigned t = 1; t < threads; ++t)
+		pool.push_back(thread(worker));
+	worker();
+	for (thread& t : pool)
+		t.join();
+}
+
+CuboidTextParser::CuboidTextParser() :
+	data(0), length(0) {}
+
+bool CuboidTextParser::formatOf(const char* filename, Format* format)
+{
+	const string name = filename;
+	if (hasExtension(name, ".csv"))
+		*format = FormatCsv;
+	else if (hasExtension(name, ".jsonl") || hasExtension(name, ".ndjson"))
+		*format = FormatJsonLines;
+	else
+		return false;
+	return true;
+}
+
+bool CuboidTextParser::open(const char* filename)
+{
+	error.clear();
+	if (!file.open(filename))
+	{
+		error = file.getError();
+		data = 0;
+		length = 0;
+		return false;
+	}
+	data = file.data();
+	length = file.size();
+	return true;
+}
+
+void CuboidTextParser::close()
+{
+	file.close();
+	data = 0;
+	length = 0;
+}
+
+bool CuboidTextParser::parse(Format format, vector<Cuboid>& cuboids,
+		unsigned threads)
+{
+	error.clear();
+	if (threads == 0)
+		threads = max(1u, thread::hardware_concurrency());
+
+	const char* begin = data;
+	const char* end = data + length;
+	size_t line = 1;
+	Columns columns = {0, 1, 2};
+	if (format == FormatCsv && !readCsvHeader(begin, line, columns))
+		return false;
+
+	// Split the rest at line boundaries.
+	size_t chunkCount = max<size_t>(1, min<size_t>(threads * chunksPerThread,
+			(end - begin) / minChunkSize));
+	threads = unsigned(min<size_t>(threads, chunkCount));
+	vector<Chunk> chunks;
+	const char* p = begin;
+	for (size_t c = 0; c < chunkCount && p < end; ++c)
+	{
+		const char* chunkEnd = begin + (end - begin) * (c + 1) / chunkCount;
+		if (chunkEnd < p)
+			chunkEnd = p;
+		if (chunkEnd < end)
+			chunkEnd = lineEnd(chunkEnd, end);
+		if (chunkEnd < end)
+			++chunkEnd;
+		chunks.push_back(Chunk{p, chunkEnd, 0, 0, 0, 0, 0, 0});
+		p = chunkEnd;
+	}
+
+	// Count lines first, to place every chunk in the output.
+	runOnThreads(chunks.size(), threads,
+			[&chunks](size_t c) { countLines(chunks[c]); });
+	size_t records = 0;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.firstLine = line;
+		chunk.first = records;
+		line += chunk.lines;
+		records += chunk.records;
+	}
+
+	const size_t initialSize = cuboids.size();
+	cuboids.resize(initialSize + records);
+	Cuboid* out = cuboids.data() + initialSize;
+	runOnThreads(chunks.size(), threads, [&](size_t c)
+			{ parseChunk(chunks[c], format, columns, out); });
+
+	for (const Chunk& chunk : chunks)
+		if (chunk.errorLine != 0)
+		{
+			error = "line " + to_string(chunk.errorLine) + ": " +
+					chunk.errorMessage;
+			cuboids.resize(initialSize);
+			return false;
+		}
+	return true;
+}
+
+bool CuboidTextParser::readCsvHeader(const char*& begin, size_t& line,
+		Columns& columns)
+{
+	const char* end = data + length;
+	while (begin < end)
+	{
+		const char* eol = lineEnd(begin, end);
+		if (isBlank(begin, eol))
+		{
+			begin = eol < end ? eol + 1 : end;
+			++line;
+			continue;
+		}
+
+		// A line of numbers has no header.
+		const char* fieldEnd = static_cast<const char*>(memchr(begin, ',',
+				eol - begin));
+		const char* first = begin;
+		const char* firstEnd = fieldEnd ? fieldEnd : eol;
+		trimField(first, firstEnd);
+		float value;
+		if (first != firstEnd && from_chars(first, firstEnd, value).ptr == firstEnd)
+			return true;
+
+		columns = Columns{-1, -1, -1};
+		int column = 0;
+		for (const char* p = begin;; ++column)
+		{
+			const char* comma = static_cast<const char*>(memchr(p, ',', eol - p));
+			const char* name = p;
+			const char* nameEnd = comma ? comma : eol;
+			trimField(name, nameEnd);
+			string_view field(name, nameEnd - name);
+			if (field == "width")
+				columns.width = column;
+			else if (field == "height")
+				columns.height = column;
+			else if (field == "depth")
+				columns.depth = column;
+			if (!comma)
+				break;
+			p = comma + 1;
+		}
+		if (columns.width < 0 || columns.height < 0 || columns.depth < 0)
+		{
+			error = "line " + to_string(line) +
+					": header without width, height or depth columns";
+			return false;
+		}
+		begin = eol < end ? eol + 1 : end;
+		++line;
+		return true;
+	}
+	return true;
+}
+
+void CuboidTextParser::countLines(Chunk& chunk)
+{
+	for (const char* p = chunk.begin; p < chunk.end;)
+	{
+		const char* eol = lineEnd(p, chunk.end);
+		if (!isBlank(p, eol))
+			++chunk.records;
+		if (eol < chunk.end)
+			++chunk.lines;
+		p = eol + 1;
+	}
+}
+
+void CuboidTextParser::parseChunk(Chunk& chunk, Format format,
+		const Columns& columns, Cuboid* out)
+{
+	size_t line = chunk.firstLine;
+	size_t position = chunk.first;
+	for (const char* p = chunk.begin; p < chunk.end; ++line)
+	{
+		const char* eol = lineEnd(p, chunk.end);
+		if (!isBlank(p, eol))
+		{
+			Cuboid& cuboid = out[position];
+			const char* message = format == FormatCsv ?
+					parseCsvLine(p, eol, columns, cuboid) :
+					parseJsonLine(p, eol, cuboid);
+			if (message)
+			{
+				chunk.errorLine = line;
+				chunk.errorMessage = message;
+				return;
+			}
+			cuboid.id = position++;
+		}
+		p = eol + 1;
+	}
+}
+
+const char* CuboidTextParser::parseCsvLine(const char* begin, const char* end,
+		const Columns& columns, Cuboid& cuboid)
+{
+	unsigned fields = 0;
+	int column = 0;
+	for (const char* p = begin;; ++column)
+	{
+		const char* comma = static_cast<const char*>(memchr(p, ',', end - p));
+		const char* fieldEnd = comma ? comma : end;
+		float* value = 0;
+		if (column == columns.width)
+		{
+			value = &cuboid.width;
+			fields |= FieldWidth;
+		}
+		else if (column == columns.height)
+		{
+			value = &cuboid.height;
+			fields |= FieldHeight;
+		}
+		else if (column == columns.depth)
+		{
+			value = &cuboid.depth;
+			fields |= FieldDepth;
+		}
+		if (value)
+		{
+			const char* field = p;
+			trimField(field, fieldEnd);
+			from_chars_result result = from_chars(field, fieldEnd, *value);
+			if (field == fieldEnd || result.ec != errc() || result.ptr != fieldEnd)
+				return "invalid number";
+			if (!isSize(*value))
+				return "size is not a positive number";
+		}
+		if (!comma)
+			break;
+		p = comma + 1;
+	}
+	if (fields != FieldAll)
+		return "line without width, height or depth";
+	return 0;
+}
+
+/* Skip a JSON string starting at the quote. @return Position after the
+ * closing quote, or 0 if it is not closed. */
+static const char* skipJsonString(const char* p, const char* end)
+{
+	for (++p; p < end; ++p)
+	{
+		if (*p == '\\')
+			++p;
+		else if (*p == '"')
+			return p + 1;
+	}
+	return 0;
+}
+
+/* Skip a JSON value, nested objects and arrays included. @return Position
+ * after the value, or 0 if it is malformed. */
+static const char* skipJsonValue(const char* p, const char* end)
+{
+	if (p == end)
+		return 0;
+	if (*p == '"')
+		return skipJsonString(p, end);
+	if (*p == '{' || *p == '[')
+	{
+		int depth = 0;
+		while (p < end)
+		{
+			if (*p == '"')
+			{
+				p = skipJsonString(p, end);
+				if (!p)
+					return 0;
+				continue;
+			}
+			if (*p == '{' || *p == '[')
+				++depth;
+			else if (*p == '}' || *p == ']')
+			{
+				if (--depth == 0)
+					return p + 1;
+			}
+			++p;
+		}
+		return 0;
+	}
+	// A number, true, false or null
+	const char* start = p;
+	while (p < end && *p != ',' && *p != '}' && *p != ']' && !isSpace(*p))
+		++p;
+	return p == start ? 0 : p;
+}
+
+const char* CuboidTextParser::parseJsonLine(const char* begin, const char* end,
+		Cuboid& cuboid)
+{
+	const char* p = skipSpaces(begin, end);
+	if (p == end || *p != '{')
+		return "expected an object";
+	p = skipSpaces(p + 1, end);
+
+	unsigned fields = 0;
+	if (p < end && *p == '}')
+		++p;
+	else
+		for (;;)
+		{
+			if (p == end || *p != '"')
+				return "expected a member name";
+			const char* name = p + 1;
+			p = skipJsonString(p, end);
+			if (!p)
+				return "unterminated string";
+			string_view key(name, p - 1 - name);
+			p = skipSpaces(p, end);
+			if (p == end || *p != ':')
+				return "expected ':'";
+			p = skipSpaces(p + 1, end);
+
+			float* value = 0;
+			if (key == "width")
+			{
+				value = &cuboid.width;
+				fields |= FieldWidth;
+			}
+			else if (key == "height")
+			{
+				value = &cuboid.height;
+				fields |= FieldHeight;
+			}
+			else if (key == "depth")
+			{
+				value = &cuboid.depth;
+				fields |= FieldDepth;
+			}
+			if (value)
+			{
+				from_chars_result result = from_chars(p, end, *value);
+				if (result.ec != errc())
+					return "invalid number";
+				if (!isSize(*value))
+					return "size is not a positive number";
+				p = result.ptr;
+			}
+			else if (!(p = skipJsonValue(p, end)))
+				return "malformed value";
+
+			p = skipSpaces(p, end);
+			if (p < end && *p == ',')
+			{
+				p = skipSpaces(p + 1, end);
+				continue;
+			}
+			if (p < end && *p == '}')
+			{
+				++p;
+				break;
+			}
+			return "expected ',' or '}'";
+		}
+
+	if (skipSpaces(p, end) != end)
+		return "text after the object";
+	if (fields != FieldAll)
+		return "object without width, height or depth";
+	return 0;
+}
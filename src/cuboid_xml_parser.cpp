@@ -0,0 +1,176 @@
+//============================================================================
+// Name        : cuboid_xml_parser.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+#include "../include/cuboid_xml_parser.hpp"
+
+using namespace std;
+
+static const char cuboidTag[] = "<cuboid";
+static const size_t cuboidTagLength = sizeof(cuboidTag) - 1;
+
+/* Bits of fields of a cuboid found in an element. */
+enum
+{
+	FieldWidth = 1,
+	FieldHeight = 2,
+	FieldDepth = 4
+};
+
+static bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isName(const char* name, size_t length, const char* expected)
+{
+	return length == strlen(expected) && memcmp(name, expected, length) == 0;
+}
+
+CuboidXmlParser::CuboidXmlParser() :
+	data(0), length(0) {}
+
+bool CuboidXmlParser::open(const char* filename)
+{
+	error.clear();
+	if (!file.open(filename))
+	{
+		error = file.getError();
+		data = 0;
+		length = 0;
+		return false;
+	}
+	data = file.data();
+	length = file.size();
+	return true;
+}
+
+void CuboidXmlParser::close()
+{
+	file.close();
+	data = 0;
+	length = 0;
+}
+
+size_t CuboidXmlParser::countCuboids() const
+{
+	const char* end = data + length;
+	size_t count = 0;
+	for (const char* p = findCuboid(data); p != end;
+			p = findCuboid(p + cuboidTagLength))
+		++count;
+	return count;
+}
+
+bool CuboidXmlParser::parse(vector<Cuboid>& cuboids)
+{
+	cuboids.reserve(cuboids.size() + countCuboids());
+	return parse([&cuboids](const Cuboid& cuboid) { cuboids.push_back(cuboid); });
+}
+
+const char* CuboidXmlParser::findCuboid(const char* p) const
+{
+	const char* end = data + length;
+	string_view text(p, end - p);
+	for (size_t position = text.find(cuboidTag); position != string_view::npos;
+			position = text.find(cuboidTag, position + cuboidTagLength))
+	{
+		// Skip other elements starting with the same name.
+		const char* tag = p + position;
+		const char* after = tag + cuboidTagLength;
+		if (after < end && (*after == '>' || isSpace(*after)))
+			return tag;
+	}
+	return end;
+}
+
+bool CuboidXmlParser::parseCuboid(const char*& p, Cuboid& cuboid)
+{
+	const char* end = data + length;
+	const char* q = static_cast<const char*>(memchr(p, '>', end - p));
+	if (q == 0)
+		return fail(p, "unterminated <cuboid> tag");
+	++q;
+
+	unsigned fields = 0;
+	for (;;)
+	{
+		while (q < end && isSpace(*q))
+			++q;
+		if (q == end || *q != '<')
+			return fail(q, "expected an element of <cuboid>");
+		++q;
+
+		if (q < end && *q == '/')
+		{
+			if (end - q < 8 || memcmp(q, "/cuboid>", 8) != 0)
+				return fail(q, "expected </cuboid>");
+			q += 8;
+			break;
+		}
+
+		const char* name = q;
+		const char* nameEnd = static_cast<const char*>(memchr(q, '>', end - q));
+		if (nameEnd == 0)
+			return fail(q, "unterminated tag");
+		size_t nameLength = nameEnd - name;
+		q = nameEnd + 1;
+
+		from_chars_result result;
+		if (isName(name, nameLength, "width"))
+		{
+			result = from_chars(q, end, cuboid.width);
+			fields |= FieldWidth;
+		}
+		else if (isName(name, nameLength, "height"))
+		{
+			result = from_chars(q, end, cuboid.height);
+			fields |= FieldHeight;
+		}
+		else if (isName(name, nameLength, "depth"))
+		{
+			result = from_chars(q, end, cuboid.depth);
+			fields |= FieldDepth;
+		}
+		else if (isName(name, nameLength, "x"))
+			result = from_chars(q, end, cuboid.x);
+		else if (isName(name, nameLength, "y"))
+			result = from_chars(q, end, cuboid.y);
+		else if (isName(name, nameLength, "z"))
+			result = from_chars(q, end, cuboid.z);
+		else if (isName(name, nameLength, "id"))
+			result = from_chars(q, end, cuboid.id);
+		else if (isName(name, nameLength, "container"))
+			result = from_chars(q, end, cuboid.container);
+		else
+			return fail(name, "unknown element of <cuboid>");
+		if (result.ec != errc())
+			return fail(q, "invalid number");
+		q = result.ptr;
+
+		// Closing tag of the same name
+		if (size_t(end - q) < nameLength + 3 || q[0] != '<' || q[1] != '/' ||
+			memcmp(q + 2, name, nameLength) != 0 || q[2 + nameLength] != '>')
+			return fail(q, "expected a closing tag");
+		q += nameLength + 3;
+	}
+
+	if (fields != (FieldWidth | FieldHeight | FieldDepth))
+		return fail(p, "<cuboid> without width, height or depth");
+	p = q;
+	return true;
+}
+
+bool CuboidXmlParser::fail(const char* at, const char* message)
+{
+	size_t line = 1 + count(data, at, '\n');
+	error = "line " + to_string(line) + ": " + message;
+	return false;
+}
@@ -0,0 +1,125 @@
+//============================================================================
+// Name        : free_cuboid_faces.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <cassert>
+#include <cstdint>
+
+#include "../include/free_cuboid_faces.hpp"
+
+using namespace std;
+
+template <class T>
+void BasicFreeCuboidFaces<T>::clear()
+{
+	lowFaces.clear();
+	highFaces.clear();
+}
+
+template <class T>
+typename BasicFreeCuboidFaces<T>::FaceKey BasicFreeCuboidFaces<T>::lowFace(
+		const BasicFreeCuboid<T>& c, int axis)
+{
+	switch (axis)
+	{
+	case 0:
+		return FaceKey{{T(0), c.x, c.y, c.height, c.z, c.depth}};
+	case 1:
+		return FaceKey{{T(1), c.y, c.x, c.width, c.z, c.depth}};
+	default:
+		return FaceKey{{T(2), c.z, c.x, c.width, c.y, c.height}};
+	}
+}
+
+template <class T>
+typename BasicFreeCuboidFaces<T>::FaceKey BasicFreeCuboidFaces<T>::highFace(
+		const BasicFreeCuboid<T>& c, int axis)
+{
+	switch (axis)
+	{
+	case 0:
+		return FaceKey{{T(0), T(c.x + c.width), c.y, c.height, c.z, c.depth}};
+	case 1:
+		return FaceKey{{T(1), T(c.y + c.height), c.x, c.width, c.z, c.depth}};
+	default:
+		return FaceKey{{T(2), T(c.z + c.depth), c.x, c.width, c.y, c.height}};
+	}
+}
+
+template <class T>
+void BasicFreeCuboidFaces<T>::insert(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned slot)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		bool inserted = lowFaces.insert(make_pair(lowFace(freeCuboid, axis),
+				slot)).second;
+		assert(inserted);
+
+		// An unbounded free cuboid has no top face.
+		if (axis == 1 && freeCuboid.unbounded)
+			continue;
+		inserted = highFaces.insert(make_pair(highFace(freeCuboid, axis),
+				slot)).second;
+		assert(inserted);
+		(void)inserted;
+	}
+}
+
+template <class T>
+void BasicFreeCuboidFaces<T>::erase(const BasicFreeCuboid<T>& freeCuboid)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		lowFaces.erase(lowFace(freeCuboid, axis));
+		if (axis == 1 && freeCuboid.unbounded)
+			continue;
+		highFaces.erase(highFace(freeCuboid, axis));
+	}
+}
+
+template <class T>
+void BasicFreeCuboidFaces<T>::setSlot(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned slot)
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		lowFaces[lowFace(freeCuboid, axis)] = slot;
+		if (axis == 1 && freeCuboid.unbounded)
+			continue;
+		highFaces[highFace(freeCuboid, axis)] = slot;
+	}
+}
+
+template <class T>
+bool BasicFreeCuboidFaces<T>::findNeighbour(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned* slot) const
+{
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		// A neighbour below: its high face is our low face.
+		auto it = highFaces.find(lowFace(freeCuboid, axis));
+		if (it != highFaces.end())
+		{
+			*slot = it->second;
+			return true;
+		}
+
+		// A neighbour above: its low face is our high face.
+		if (axis == 1 && freeCuboid.unbounded)
+			continue;
+		it = lowFaces.find(highFace(freeCuboid, axis));
+		if (it != lowFaces.end())
+		{
+			*slot = it->second;
+			return true;
+		}
+	}
+	return false;
+}
+
+template class BasicFreeCuboidFaces<float>;
+template class BasicFreeCuboidFaces<int32_t>;
+template class BasicFreeCuboidFaces<int16_t>;
@@ -0,0 +1,184 @@
+//============================================================================
+// Name        : free_cuboid_index.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+
+#include "../include/free_cuboid_index.hpp"
+
+using namespace std;
+
+template <class T>
+BasicFreeCuboidIndex<T>::Edges::Edges(T width, T height, T depth)
+{
+	e[0] = width;
+	e[1] = height;
+	e[2] = depth;
+	if (e[0] > e[1]) swap(e[0], e[1]);
+	if (e[1] > e[2]) swap(e[1], e[2]);
+	if (e[0] > e[1]) swap(e[0], e[1]);
+}
+
+template <class T>
+void BasicFreeCuboidIndex<T>::clear()
+{
+	// Keep the storage of entries, so a reused index does not allocate.
+	buckets.clear();
+	freeSlots.clear();
+	for (unsigned slot = entries.size(); slot > 0; --slot)
+	{
+		entries[slot - 1].clear();
+		freeSlots.push_back(slot - 1);
+	}
+}
+
+template <class T>
+typename vector<typename BasicFreeCuboidIndex<T>::Bucket>::iterator
+BasicFreeCuboidIndex<T>::findBucket(T y)
+{
+	return lower_bound(buckets.begin(), buckets.end(), y,
+			[](const Bucket& b, T y) { return b.y < y; });
+}
+
+template <class T>
+void BasicFreeCuboidIndex<T>::insert(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned long seq, unsigned slot)
+{
+	auto it = findBucket(freeCuboid.y);
+	if (it == buckets.end() || it->y != freeCuboid.y)
+	{
+		Bucket bucket;
+		bucket.y = freeCuboid.y;
+		bucket.maxEdges = Edges(0, 0, 0);
+		if (freeSlots.empty())
+		{
+			bucket.slot = entries.size();
+			entries.push_back(vector<Entry>());
+		}
+		else
+		{
+			bucket.slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		it = buckets.insert(it, bucket);
+	}
+
+	Entry entry;
+	entry.seq = seq;
+	entry.slot = slot;
+	entry.edges = Edges(freeCuboid.width, freeCuboid.height, freeCuboid.depth);
+
+	// New free cuboids have the highest sequence number, only free cuboids
+	// restored by Guillotine3d::rollback() are inserted in the middle.
+	vector<Entry>& bucketEntries = entries[it->slot];
+	if (bucketEntries.empty() || bucketEntries.back().seq < seq)
+		bucketEntries.push_back(entry);
+	else
+	{
+		auto pos = lower_bound(bucketEntries.begin(), bucketEntries.end(), seq,
+				[](const Entry& e, unsigned long s) { return e.seq < s; });
+		assert(pos->seq != seq);
+		bucketEntries.insert(pos, entry);
+	}
+
+	for (int i = 0; i < 3; ++i)
+		it->maxEdges.e[i] = max(it->maxEdges.e[i], entry.edges.e[i]);
+}
+
+template <class T>
+typename vector<typename BasicFreeCuboidIndex<T>::Entry>::iterator
+BasicFreeCuboidIndex<T>::findEntry(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned long seq, typename vector<Bucket>::iterator* bucket)
+{
+	*bucket = findBucket(freeCuboid.y);
+	assert(*bucket != buckets.end() && (*bucket)->y == freeCuboid.y);
+	vector<Entry>& bucketEntries = entries[(*bucket)->slot];
+
+	auto entry = lower_bound(bucketEntries.begin(), bucketEntries.end(), seq,
+			[](const Entry& e, unsigned long s) { return e.seq < s; });
+	assert(entry != bucketEntries.end() && entry->seq == seq);
+	return entry;
+}
+
+template <class T>
+void BasicFreeCuboidIndex<T>::erase(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned long seq)
+{
+	typename vector<Bucket>::iterator it;
+	auto entry = findEntry(freeCuboid, seq, &it);
+	vector<Entry>& bucketEntries = entries[it->slot];
+	bucketEntries.erase(entry);
+
+	if (bucketEntries.empty())
+	{
+		freeSlots.push_back(it->slot);
+		buckets.erase(it);
+	}
+	else
+		updateSummary(*it);
+}
+
+template <class T>
+void BasicFreeCuboidIndex<T>::setSlot(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned long seq, unsigned slot)
+{
+	typename vector<Bucket>::iterator it;
+	findEntry(freeCuboid, seq, &it)->slot = slot;
+}
+
+template <class T>
+bool BasicFreeCuboidIndex<T>::findMinHeight(const BasicItem<T>& item,
+		unsigned* slot) const
+{
+	const Edges edges(item.sortedEdges);
+	bool found = false;
+	unsigned long bestSeq = 0;
+	float bestScore = numeric_limits<float>::max();
+
+	// Buckets are visited in increasing y, so the score never decreases.
+	// Buckets with the same score as the best one found so far still have
+	// to be checked, because they can hold a free cuboid with a lower
+	// sequence number.
+	for (const Bucket& bucket : buckets)
+	{
+		float score = bucket.y + item.height;
+		if (found && score > bestScore)
+			break;
+
+		if (!edges.fitsInto(bucket.maxEdges))
+			continue;
+
+		for (const Entry& e : entries[bucket.slot])
+		{
+			if (found && score == bestScore && e.seq > bestSeq)
+				break;
+			if (edges.fitsInto(e.edges))
+			{
+				found = true;
+				bestScore = score;
+				bestSeq = e.seq;
+				*slot = e.slot;
+				break;
+			}
+		}
+	}
+	return found;
+}
+
+template <class T>
+void BasicFreeCuboidIndex<T>::updateSummary(Bucket& bucket)
+{
+	bucket.maxEdges = Edges(0, 0, 0);
+	for (const Entry& e : entries[bucket.slot])
+		for (int i = 0; i < 3; ++i)
+			bucket.maxEdges.e[i] = max(bucket.maxEdges.e[i], e.edges.e[i]);
+}
+
+template class BasicFreeCuboidIndex<float>;
+template class BasicFreeCuboidIndex<int32_t>;
+template class BasicFreeCuboidIndex<int16_t>;
@@ -0,0 +1,448 @@
+//============================================================================
+// Name        : free_cuboid_store.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <cassert>
+
+#include "../include/free_cuboid_store.hpp"
+#include "../include/item.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FREE_CUBOID_STORE_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+template <class T>
+void BasicFreeCuboidStore<T>::clear()
+{
+	x.clear();
+	y.clear();
+	z.clear();
+	width.clear();
+	height.clear();
+	depth.clear();
+	seq.clear();
+	unbounded.clear();
+}
+
+template <class T>
+void BasicFreeCuboidStore<T>::push_back(const BasicFreeCuboid<T>& freeCuboid,
+		unsigned long freeCuboidSeq)
+{
+	x.push_back(freeCuboid.x);
+	y.push_back(freeCuboid.y);
+	z.push_back(freeCuboid.z);
+	width.push_back(freeCuboid.width);
+	height.push_back(freeCuboid.height);
+	depth.push_back(freeCuboid.depth);
+	seq.push_back(freeCuboidSeq);
+	unbounded.push_back(freeCuboid.unbounded);
+}
+
+template <class T>
+void BasicFreeCuboidStore<T>::erase(size_t index)
+{
+	const size_t last = size() - 1;
+	x[index] = x[last];
+	y[index] = y[last];
+	z[index] = z[last];
+	width[index] = width[last];
+	height[index] = height[last];
+	depth[index] = depth[last];
+	seq[index] = seq[last];
+	unbounded[index] = unbounded[last];
+	pop_back();
+}
+
+template <class T>
+void BasicFreeCuboidStore<T>::insert(size_t index,
+		const BasicFreeCuboid<T>& freeCuboid, unsigned long freeCuboidSeq)
+{
+	assert(index <= size());
+	push_back(freeCuboid, freeCuboidSeq);
+	if (index == size() - 1)
+		return;
+
+	const size_t last = size() - 1;
+	swap(x[index], x[last]);
+	swap(y[index], y[last]);
+	swap(z[index], z[last]);
+	swap(width[index], width[last]);
+	swap(height[index], height[last]);
+	swap(depth[index], depth[last]);
+	swap(seq[index], seq[last]);
+	swap(unbounded[index], unbounded[last]);
+}
+
+template <class T>
+void BasicFreeCuboidStore<T>::pop_back()
+{
+	x.pop_back();
+	y.pop_back();
+	z.pop_back();
+	width.pop_back();
+	height.pop_back();
+	depth.pop_back();
+	seq.pop_back();
+	unbounded.pop_back();
+}
+
+template <class T>
+BasicFreeCuboid<T> BasicFreeCuboidStore<T>::operator[](size_t index) const
+{
+	BasicFreeCuboid<T> c;
+	c.width = width[index];
+	c.height = height[index];
+	c.depth = depth[index];
+	c.x = x[index];
+	c.y = y[index];
+	c.z = z[index];
+	c.unbounded = unbounded[index];
+	return c;
+}
+
+/* Scalar fit test of free cuboids [first + begin, first + count). */
+template <class T>
+static void fitMasksScalar(const T* w, const T* h, const T* d,
+		size_t first, size_t begin, size_t count, const T edges[3],
+		uint64_t masks[6])
+{
+	for (size_t i = begin; i < count; ++i)
+	{
+		const size_t j = first + i;
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			if (edges[orientation[0]] <= w[j] &&
+				edges[orientation[1]] <= h[j] &&
+				edges[orientation[2]] <= d[j])
+				masks[o] |= uint64_t(1) << i;
+		}
+	}
+}
+
+#ifdef FREE_CUBOID_STORE_X86
+
+__attribute__((target("sse2")))
+static size_t fitMasksSse(const float* w, const float* h, const float* d,
+		size_t first, size_t count, const float edges[3], uint64_t masks[6])
+{
+	__m128 e[3];
+	for (int k = 0; k < 3; ++k)
+		e[k] = _mm_set1_ps(edges[k]);
+
+	// Test 8 free cuboids per step, as two groups of 4.
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const size_t j = first + i;
+		const __m128 w0 = _mm_loadu_ps(w + j), w1 = _mm_loadu_ps(w + j + 4);
+		const __m128 h0 = _mm_loadu_ps(h + j), h1 = _mm_loadu_ps(h + j + 4);
+		const __m128 d0 = _mm_loadu_ps(d + j), d1 = _mm_loadu_ps(d + j + 4);
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			const __m128 a = e[orientation[0]];
+			const __m128 b = e[orientation[1]];
+			const __m128 c = e[orientation[2]];
+			const __m128 fit0 = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(a, w0),
+					_mm_cmple_ps(b, h0)), _mm_cmple_ps(c, d0));
+			const __m128 fit1 = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(a, w1),
+					_mm_cmple_ps(b, h1)), _mm_cmple_ps(c, d1));
+			const unsigned bits = _mm_movemask_ps(fit0) |
+					(_mm_movemask_ps(fit1) << 4);
+			masks[o] |= uint64_t(bits) << i;
+		}
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t fitMasksAvx2(const float* w, const float* h, const float* d,
+		size_t first, size_t count, const float edges[3], uint64_t masks[6])
+{
+	__m256 e[3];
+	for (int k = 0; k < 3; ++k)
+		e[k] = _mm256_set1_ps(edges[k]);
+
+	// Test 16 free cuboids per step, as two groups of 8.
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const size_t j = first + i;
+		const __m256 w0 = _mm256_loadu_ps(w + j), w1 = _mm256_loadu_ps(w + j + 8);
+		const __m256 h0 = _mm256_loadu_ps(h + j), h1 = _mm256_loadu_ps(h + j + 8);
+		const __m256 d0 = _mm256_loadu_ps(d + j), d1 = _mm256_loadu_ps(d + j + 8);
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			const __m256 a = e[orientation[0]];
+			const __m256 b = e[orientation[1]];
+			const __m256 c = e[orientation[2]];
+			const __m256 fit0 = _mm256_and_ps(_mm256_and_ps(
+					_mm256_cmp_ps(a, w0, _CMP_LE_OQ),
+					_mm256_cmp_ps(b, h0, _CMP_LE_OQ)),
+					_mm256_cmp_ps(c, d0, _CMP_LE_OQ));
+			const __m256 fit1 = _mm256_and_ps(_mm256_and_ps(
+					_mm256_cmp_ps(a, w1, _CMP_LE_OQ),
+					_mm256_cmp_ps(b, h1, _CMP_LE_OQ)),
+					_mm256_cmp_ps(c, d1, _CMP_LE_OQ));
+			const unsigned bits = _mm256_movemask_ps(fit0) |
+					(_mm256_movemask_ps(fit1) << 8);
+			masks[o] |= uint64_t(bits) << i;
+		}
+	}
+	return i;
+}
+
+
+/* Integer kernels compare with "greater than" and invert the result: a
+ * cuboid fits if none of its edges is greater than the free cuboid edge. */
+
+__attribute__((target("sse2")))
+static size_t fitMasksSse(const int32_t* w, const int32_t* h, const int32_t* d,
+		size_t first, size_t count, const int32_t edges[3], uint64_t masks[6])
+{
+	__m128i e[3];
+	for (int k = 0; k < 3; ++k)
+		e[k] = _mm_set1_epi32(edges[k]);
+
+	// Test 8 free cuboids per step, as two groups of 4.
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const size_t j = first + i;
+		const __m128i* pw = reinterpret_cast<const __m128i*>(w + j);
+		const __m128i* ph = reinterpret_cast<const __m128i*>(h + j);
+		const __m128i* pd = reinterpret_cast<const __m128i*>(d + j);
+		const __m128i w0 = _mm_loadu_si128(pw), w1 = _mm_loadu_si128(pw + 1);
+		const __m128i h0 = _mm_loadu_si128(ph), h1 = _mm_loadu_si128(ph + 1);
+		const __m128i d0 = _mm_loadu_si128(pd), d1 = _mm_loadu_si128(pd + 1);
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			const __m128i a = e[orientation[0]];
+			const __m128i b = e[orientation[1]];
+			const __m128i c = e[orientation[2]];
+			const __m128i over0 = _mm_or_si128(_mm_or_si128(
+					_mm_cmpgt_epi32(a, w0), _mm_cmpgt_epi32(b, h0)),
+					_mm_cmpgt_epi32(c, d0));
+			const __m128i over1 = _mm_or_si128(_mm_or_si128(
+					_mm_cmpgt_epi32(a, w1), _mm_cmpgt_epi32(b, h1)),
+					_mm_cmpgt_epi32(c, d1));
+			const unsigned bits = _mm_movemask_ps(_mm_castsi128_ps(over0)) |
+					(_mm_movemask_ps(_mm_castsi128_ps(over1)) << 4);
+			masks[o] |= uint64_t(~bits & 0xff) << i;
+		}
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t fitMasksAvx2(const int32_t* w, const int32_t* h, const int32_t* d,
+		size_t first, size_t count, const int32_t edges[3], uint64_t masks[6])
+{
+	__m256i e[3];
+	for (int k = 0; k < 3; ++k)
+		e[k] = _mm256_set1_epi32(edges[k]);
+
+	// Test 16 free cuboids per step, as two groups of 8.
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const size_t j = first + i;
+		const __m256i* pw = reinterpret_cast<const __m256i*>(w + j);
+		const __m256i* ph = reinterpret_cast<const __m256i*>(h + j);
+		const __m256i* pd = reinterpret_cast<const __m256i*>(d + j);
+		const __m256i w0 = _mm256_loadu_si256(pw), w1 = _mm256_loadu_si256(pw + 1);
+		const __m256i h0 = _mm256_loadu_si256(ph), h1 = _mm256_loadu_si256(ph + 1);
+		const __m256i d0 = _mm256_loadu_si256(pd), d1 = _mm256_loadu_si256(pd + 1);
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			const __m256i a = e[orientation[0]];
+			const __m256i b = e[orientation[1]];
+			const __m256i c = e[orientation[2]];
+			const __m256i over0 = _mm256_or_si256(_mm256_or_si256(
+					_mm256_cmpgt_epi32(a, w0), _mm256_cmpgt_epi32(b, h0)),
+					_mm256_cmpgt_epi32(c, d0));
+			const __m256i over1 = _mm256_or_si256(_mm256_or_si256(
+					_mm256_cmpgt_epi32(a, w1), _mm256_cmpgt_epi32(b, h1)),
+					_mm256_cmpgt_epi32(c, d1));
+			const unsigned bits =
+					_mm256_movemask_ps(_mm256_castsi256_ps(over0)) |
+					(_mm256_movemask_ps(_mm256_castsi256_ps(over1)) << 8);
+			masks[o] |= uint64_t(~bits & 0xffff) << i;
+		}
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static size_t fitMasksSse(const int16_t* w, const int16_t* h, const int16_t* d,
+		size_t first, size_t count, const int16_t edges[3], uint64_t masks[6])
+{
+	__m128i e[3];
+	for (int k = 0; k < 3; ++k)
+		e[k] = _mm_set1_epi16(edges[k]);
+
+	// Test 16 free cuboids per step, as two groups of 8. Results of 16 bit
+	// compares are packed to bytes to get one bit per free cuboid.
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		const size_t j = first + i;
+		const __m128i* pw = reinterpret_cast<const __m128i*>(w + j);
+		const __m128i* ph = reinterpret_cast<const __m128i*>(h + j);
+		const __m128i* pd = reinterpret_cast<const __m128i*>(d + j);
+		const __m128i w0 = _mm_loadu_si128(pw), w1 = _mm_loadu_si128(pw + 1);
+		const __m128i h0 = _mm_loadu_si128(ph), h1 = _mm_loadu_si128(ph + 1);
+		const __m128i d0 = _mm_loadu_si128(pd), d1 = _mm_loadu_si128(pd + 1);
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			const __m128i a = e[orientation[0]];
+			const __m128i b = e[orientation[1]];
+			const __m128i c = e[orientation[2]];
+			const __m128i over0 = _mm_or_si128(_mm_or_si128(
+					_mm_cmpgt_epi16(a, w0), _mm_cmpgt_epi16(b, h0)),
+					_mm_cmpgt_epi16(c, d0));
+			const __m128i over1 = _mm_or_si128(_mm_or_si128(
+					_mm_cmpgt_epi16(a, w1), _mm_cmpgt_epi16(b, h1)),
+					_mm_cmpgt_epi16(c, d1));
+			const unsigned bits =
+					_mm_movemask_epi8(_mm_packs_epi16(over0, over1));
+			masks[o] |= uint64_t(~bits & 0xffff) << i;
+		}
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static size_t fitMasksAvx2(const int16_t* w, const int16_t* h, const int16_t* d,
+		size_t first, size_t count, const int16_t edges[3], uint64_t masks[6])
+{
+	__m256i e[3];
+	for (int k = 0; k < 3; ++k)
+		e[k] = _mm256_set1_epi16(edges[k]);
+
+	// Test 32 free cuboids per step, as two groups of 16. Packing works
+	// within 128 bit lanes, so the packed quarters are put back in order.
+	size_t i = 0;
+	for (; i + 32 <= count; i += 32)
+	{
+		const size_t j = first + i;
+		const __m256i* pw = reinterpret_cast<const __m256i*>(w + j);
+		const __m256i* ph = reinterpret_cast<const __m256i*>(h + j);
+		const __m256i* pd = reinterpret_cast<const __m256i*>(d + j);
+		const __m256i w0 = _mm256_loadu_si256(pw), w1 = _mm256_loadu_si256(pw + 1);
+		const __m256i h0 = _mm256_loadu_si256(ph), h1 = _mm256_loadu_si256(ph + 1);
+		const __m256i d0 = _mm256_loadu_si256(pd), d1 = _mm256_loadu_si256(pd + 1);
+		for (int o = 0; o < 6; ++o)
+		{
+			const int* orientation = itemOrientations[o];
+			const __m256i a = e[orientation[0]];
+			const __m256i b = e[orientation[1]];
+			const __m256i c = e[orientation[2]];
+			const __m256i over0 = _mm256_or_si256(_mm256_or_si256(
+					_mm256_cmpgt_epi16(a, w0), _mm256_cmpgt_epi16(b, h0)),
+					_mm256_cmpgt_epi16(c, d0));
+			const __m256i over1 = _mm256_or_si256(_mm256_or_si256(
+					_mm256_cmpgt_epi16(a, w1), _mm256_cmpgt_epi16(b, h1)),
+					_mm256_cmpgt_epi16(c, d1));
+			const __m256i packed = _mm256_permute4x64_epi64(
+					_mm256_packs_epi16(over0, over1), 0xd8);
+			const unsigned bits = _mm256_movemask_epi8(packed);
+			masks[o] |= uint64_t(~bits) << i;
+		}
+	}
+	return i;
+}
+
+#endif
+
+template <class T>
+void BasicFreeCuboidStore<T>::fitMasks(size_t first, size_t count,
+		T w, T h, T d, uint64_t masks[6]) const
+{
+	assert(count <= maskBlock && first + count <= size());
+
+	const T edges[3] = {w, h, d};
+	for (int o = 0; o < 6; ++o)
+		masks[o] = 0;
+
+	// The vector kernels test whole groups of free cuboids, the rest is
+	// tested by the scalar code.
+	size_t done = 0;
+	switch (kernel)
+	{
+#ifdef FREE_CUBOID_STORE_X86
+	case FitKernelAvx2:
+		done = fitMasksAvx2(width.data(), height.data(), depth.data(),
+				first, count, edges, masks);
+		break;
+	case FitKernelSse:
+		done = fitMasksSse(width.data(), height.data(), depth.data(),
+				first, count, edges, masks);
+		break;
+#endif
+	default:
+		break;
+	}
+	fitMasksScalar(width.data(), height.data(), depth.data(),
+			first, done, count, edges, masks);
+}
+
+template <class T>
+bool BasicFreeCuboidStore<T>::setFitKernel(FitKernel fitKernel)
+{
+	if (!isFitKernelSupported(fitKernel))
+		return false;
+	kernel = fitKernel;
+	return true;
+}
+
+bool FreeCuboidStoreBase::isFitKernelSupported(FitKernel fitKernel)
+{
+	switch (fitKernel)
+	{
+	case FitKernelScalar:
+		return true;
+#ifdef FREE_CUBOID_STORE_X86
+	case FitKernelSse:
+		return __builtin_cpu_supports("sse2");
+	case FitKernelAvx2:
+		return __builtin_cpu_supports("avx2");
+#endif
+	default:
+		return false;
+	}
+}
+
+FreeCuboidStoreBase::FitKernel FreeCuboidStoreBase::bestFitKernel()
+{
+	static const FitKernel best =
+			isFitKernelSupported(FitKernelAvx2) ? FitKernelAvx2 :
+			isFitKernelSupported(FitKernelSse) ? FitKernelSse :
+			FitKernelScalar;
+	return best;
+}
+
+const char* FreeCuboidStoreBase::fitKernelName(FitKernel fitKernel)
+{
+	switch (fitKernel)
+	{
+	case FitKernelScalar: return "scalar";
+	case FitKernelSse: return "sse";
+	case FitKernelAvx2: return "avx2";
+	default: return "unknown";
+	}
+}
+
+template class BasicFreeCuboidStore<float>;
+template class BasicFreeCuboidStore<int32_t>;
+template class BasicFreeCuboidStore<int16_t>;
@@ -0,0 +1,425 @@
+//============================================================================
+// Name        : global_search.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#include "../include/global_search.hpp"
+
+using namespace std;
+
+template <class T>
+BasicGlobalSearch<T>::BasicGlobalSearch(const BasicGuillotine3d<T>& emptyBin,
+		Guillotine3dBase::FreeCuboidChoiceHeuristic cuboidChoice,
+		Guillotine3dBase::GuillotineSplitHeuristic splitMethod) :
+		emptyBin(emptyBin), binWidth(emptyBin.getBinWidth()),
+		binDepth(emptyBin.getBinDepth()), cuboidChoice(cuboidChoice),
+		splitMethod(splitMethod), lowerBound(0), visitedNodes(0),
+		nodeLimit(0), optimal(false), nextTask(0), incumbent(0),
+		sharedVisited(0), aborted(false),
+		bestHeight(numeric_limits<T>::max()), best(emptyBin)
+{
+	assert(emptyBin.getPlacements().empty());
+}
+
+template <class T>
+void BasicGlobalSearch<T>::prepare(const vector<BasicItem<T> >& cuboids)
+{
+	items = cuboids;
+	stable_sort(items.begin(), items.end(), &BasicItem<T>::compareMaxEdge);
+
+	previousEqual.assign(items.size(), -1);
+	for (unsigned i = 0; i < items.size(); ++i)
+	{
+		for (int j = i - 1; j >= 0; --j)
+		{
+			if (items[j].width == items[i].width &&
+				items[j].height == items[i].height &&
+				items[j].depth == items[i].depth)
+			{
+				previousEqual[i] = j;
+				break;
+			}
+		}
+	}
+
+	lowerBound = computeLowerBound();
+	visitedNodes = 0;
+	bestHeight = numeric_limits<T>::max();
+	best = emptyBin;
+}
+
+template <class T>
+T BasicGlobalSearch<T>::computeLowerBound() const
+{
+	float maxVertical = 0;
+	double volume = 0;
+	bool integral = true;
+	for (const BasicItem<T>& c : items)
+	{
+		// The lowest edge which can stand, while the two others fit the base.
+		const float edges[3] = {float(c.width), float(c.height), float(c.depth)};
+		float minVertical = numeric_limits<float>::max();
+		for (int v = 0; v < 3; ++v)
+		{
+			float a = edges[(v + 1) % 3];
+			float b = edges[(v + 2) % 3];
+			if ((a <= binWidth && b <= binDepth) ||
+				(a <= binDepth && b <= binWidth))
+				minVertical = min(minVertical, edges[v]);
+		}
+
+		// A cuboid which does not fit the base is never placed.
+		if (minVertical == numeric_limits<float>::max())
+			continue;
+
+		maxVertical = max(maxVertical, minVertical);
+		volume += double(c.width) * c.height * c.depth;
+		integral = integral && c.width == floor(c.width) &&
+				c.height == floor(c.height) && c.depth == floor(c.depth);
+	}
+
+	// With integral sizes every height is integral, so the volume bound
+	// can be rounded up. Otherwise it is rounded down to T, to stay a bound
+	// of heights summed in T.
+	double volumeBound = volume / (double(binWidth) * binDepth);
+	if (integral)
+		volumeBound = ceil(volumeBound);
+	T bound = T(volumeBound);
+	if (double(bound) > volumeBound)
+		bound = nextafter(bound, T(0));
+	return max(T(maxVertical), bound);
+}
+
+template <class T>
+T BasicGlobalSearch<T>::insertItem(BasicGuillotine3d<T>& bin, unsigned item,
+		T height) const
+{
+	BasicPlacement<T> placed;
+	if (bin.insert(items[item], cuboidChoice, splitMethod, &placed))
+		height = max(height, T(placed.y + placed.height(items[item])));
+	return height;
+}
+
+template <class T>
+BasicGlobalSearch<T>::Worker::Worker(const BasicGuillotine3d<T>& emptyBin,
+		size_t items) :
+		bin(emptyBin), used(items, false), visited(0), unreported(0), task(0),
+		bestKey(UINT64_MAX), bestHeight(0)
+{
+	emptyMark = bin.mark();
+	order.reserve(items);
+}
+
+template <class T>
+BasicGuillotine3d<T> BasicGlobalSearch<T>::replay(
+		const vector<unsigned>& order) const
+{
+	BasicGuillotine3d<T> bin(emptyBin);
+	for (unsigned item : order)
+		bin.insert(items[item], cuboidChoice, splitMethod);
+	return bin;
+}
+
+template <class T>
+BasicGuillotine3d<T> BasicGlobalSearch<T>::branchAndBound(
+		const vector<BasicItem<T> >& cuboids, unsigned long limit,
+		unsigned threads)
+{
+	prepare(cuboids);
+	nodeLimit = limit;
+	threads = max(threads, 1u);
+
+	// Tasks are orders of the first two cuboids.
+	tasks.clear();
+	vector<unsigned> prefix;
+	vector<bool> prefixUsed(items.size(), false);
+	generateTasks(min<size_t>(2, items.size()), prefix, prefixUsed);
+
+	// The order sorted by the longest edge is the starting incumbent, so a
+	// search stopped by the node limit still returns a complete order. Its
+	// task is after all others, so an equal order found by a task wins.
+	BasicGuillotine3d<T> greedy(emptyBin);
+	T greedyHeight = 0;
+	for (unsigned i = 0; i < items.size(); ++i)
+		greedyHeight = insertItem(greedy, i, greedyHeight);
+	bestHeight = greedyHeight;
+	best = greedy;
+
+	nextTask = 0;
+	incumbent = key(bestHeight, tasks.size());
+	sharedVisited = 0;
+	aborted = false;
+
+	vector<Worker> workers(threads, Worker(emptyBin, items.size()));
+	if (threads == 1)
+		runWorker(workers[0]);
+	else
+	{
+		vector<thread> pool;
+		for (Worker& worker : workers)
+			pool.push_back(thread(&BasicGlobalSearch<T>::runWorker, this, ref(worker)));
+		for (thread& t : pool)
+			t.join();
+	}
+
+	// The worker which stored the incumbent has its order, unless it is
+	// still the greedy one.
+	for (const Worker& worker : workers)
+	{
+		visitedNodes += worker.visited;
+		if (worker.bestKey == incumbent)
+		{
+			bestHeight = worker.bestHeight;
+			best = replay(worker.bestOrder);
+		}
+	}
+
+	optimal = !aborted || bestHeight <= lowerBound;
+	return best;
+}
+
+template <class T>
+void BasicGlobalSearch<T>::generateTasks(unsigned taskLength,
+		vector<unsigned>& prefix, vector<bool>& used)
+{
+	if (prefix.size() == taskLength)
+	{
+		tasks.push_back(prefix);
+		return;
+	}
+
+	for (unsigned i = 0; i < items.size(); ++i)
+	{
+		if (!canInsertNext(i, used))
+			continue;
+		used[i] = true;
+		prefix.push_back(i);
+		generateTasks(taskLength, prefix, used);
+		prefix.pop_back();
+		used[i] = false;
+	}
+}
+
+template <class T>
+void BasicGlobalSearch<T>::runWorker(Worker& worker)
+{
+	while (!aborted)
+	{
+		unsigned task = nextTask++;
+		if (task >= tasks.size())
+			break;
+		worker.task = task;
+
+		// Insert the first cuboids of the task.
+		worker.bin.rollback(worker.emptyMark);
+		worker.order.clear();
+		fill(worker.used.begin(), worker.used.end(), false);
+		const vector<unsigned>& prefix = tasks[task];
+		T height = 0;
+		bool pruned = false;
+		for (unsigned length = 0; length < prefix.size() && !pruned; ++length)
+		{
+			height = insertItem(worker.bin, prefix[length], height);
+			worker.order.push_back(prefix[length]);
+			worker.used[prefix[length]] = true;
+			pruned = !canBeat(max(height, lowerBound), task);
+		}
+
+		if (!pruned)
+			branch(worker, prefix.size(), height);
+	}
+	sharedVisited += worker.unreported;
+}
+
+template <class T>
+bool BasicGlobalSearch<T>::visitNode(Worker& worker)
+{
+	++worker.visited;
+	if (nodeLimit == 0)
+		return true;
+
+	// Report visited nodes in batches, to not contend on the counter.
+	if (++worker.unreported == 256)
+	{
+		if (sharedVisited.fetch_add(worker.unreported) + worker.unreported >
+				nodeLimit)
+			aborted = true;
+		worker.unreported = 0;
+	}
+	return !aborted;
+}
+
+template <class T>
+void BasicGlobalSearch<T>::branch(Worker& worker, unsigned length, T height)
+{
+	if (!visitNode(worker))
+		return;
+
+	if (length == items.size())
+	{
+		// Store the order if it is better than the incumbent.
+		uint64_t newKey = key(height, worker.task);
+		uint64_t current = incumbent.load();
+		while (newKey < current)
+		{
+			if (incumbent.compare_exchange_weak(current, newKey))
+			{
+				worker.bestKey = newKey;
+				worker.bestHeight = height;
+				worker.bestOrder = worker.order;
+				break;
+			}
+		}
+		return;
+	}
+
+	const typename BasicGuillotine3d<T>::Mark mark = worker.bin.mark();
+	for (unsigned i = 0; i < items.size(); ++i)
+	{
+		if (!canInsertNext(i, worker.used))
+			continue;
+
+		T newHeight = insertItem(worker.bin, i, height);
+
+		// The height never decreases, so this partial order can not beat the
+		// best one.
+		if (canBeat(max(newHeight, lowerBound), worker.task))
+		{
+			worker.used[i] = true;
+			worker.order.push_back(i);
+			branch(worker, length + 1, newHeight);
+			worker.order.pop_back();
+			worker.used[i] = false;
+		}
+		worker.bin.rollback(mark);
+
+		if (aborted || !canBeat(lowerBound, worker.task))
+			return;
+	}
+}
+
+template <class T>
+BasicGuillotine3d<T> BasicGlobalSearch<T>::beamSearch(
+		const vector<BasicItem<T> >& cuboids, unsigned beamWidth)
+{
+	assert(beamWidth > 0);
+	prepare(cuboids);
+
+	struct Node
+	{
+		BasicGuillotine3d<T> bin;
+		vector<bool> used;
+		T height;
+		double volume;
+	};
+
+	struct Candidate
+	{
+		unsigned parent;
+		unsigned item;
+		double waste;
+		T height;
+		double volume;
+
+		bool operator<(const Candidate& other) const
+		{
+			if (waste != other.waste)
+				return waste < other.waste;
+			return height < other.height;
+		}
+	};
+
+	const double baseArea = double(binWidth) * binDepth;
+
+	// The order sorted by the longest edge is the starting best result.
+	BasicGuillotine3d<T> greedy(emptyBin);
+	T greedyHeight = 0;
+	for (unsigned i = 0; i < items.size(); ++i)
+		greedyHeight = insertItem(greedy, i, greedyHeight);
+	bestHeight = greedyHeight;
+	best = greedy;
+
+	vector<Node> beam;
+	beam.push_back(Node{emptyBin, vector<bool>(items.size(), false), 0, 0});
+
+	vector<Candidate> candidates;
+	for (unsigned length = 0; length < items.size(); ++length)
+	{
+		// Score extensions of every partial order in the beam by the volume
+		// wasted below its height. Only the first beamWindow remaining items
+		// are tried, otherwise flat cuboids would be always chosen first.
+		candidates.clear();
+		for (unsigned p = 0; p < beam.size(); ++p)
+		{
+			BasicGuillotine3d<T>& bin = beam[p].bin;
+			const typename BasicGuillotine3d<T>::Mark mark = bin.mark();
+			unsigned window = 0;
+			for (unsigned i = 0; i < items.size() && window < beamWindow; ++i)
+			{
+				if (!canInsertNext(i, beam[p].used))
+					continue;
+				++window;
+
+				++visitedNodes;
+				BasicPlacement<T> placement;
+				const bool isPlaced = bin.insert(items[i], cuboidChoice,
+						splitMethod, &placement);
+				T height = beam[p].height;
+				double volume = beam[p].volume;
+				if (isPlaced)
+				{
+					const BasicCuboid<T> placed = placement.cuboid(items[i]);
+					height = max(height, T(placed.y + placed.height));
+					volume += double(placed.width) * placed.height *
+							placed.depth;
+				}
+				candidates.push_back(Candidate{p, i,
+						height * baseArea - volume, height, volume});
+				bin.rollback(mark);
+			}
+		}
+
+		// Keep the best extensions.
+		size_t kept = min<size_t>(beamWidth, candidates.size());
+		partial_sort(candidates.begin(), candidates.begin() + kept,
+				candidates.end());
+
+		vector<Node> next;
+		next.reserve(kept);
+		for (size_t c = 0; c < kept; ++c)
+		{
+			const Candidate& candidate = candidates[c];
+			Node child = beam[candidate.parent];
+			child.height = insertItem(child.bin, candidate.item, child.height);
+			// The journal is needed only while scoring the candidates.
+			child.bin.discardMarks();
+			child.volume = candidate.volume;
+			child.used[candidate.item] = true;
+			next.push_back(child);
+		}
+		beam.swap(next);
+	}
+
+	for (const Node& node : beam)
+	{
+		if (node.height < bestHeight)
+		{
+			bestHeight = node.height;
+			best = node.bin;
+		}
+	}
+	optimal = bestHeight <= lowerBound;
+	return best;
+}
+
+template class BasicGlobalSearch<float>;
+template class BasicGlobalSearch<int32_t>;
+template class BasicGlobalSearch<int16_t>;
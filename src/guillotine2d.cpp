@@ -7,9 +7,25 @@
 #include <cmath>
 #include <limits>
 #include "../include/guillotine2d.hpp"
+#include "../include/guillotine_policies.hpp"
 
+// Every heuristic is compiled once, in the order of the enums.
+const Guillotine2d::FindPositionFunction
+Guillotine2d::findPositionFunctions[] = {
+	&Guillotine2d::findPositionForNewRect<RectBestAreaFitScore>,
+	&Guillotine2d::findPositionForNewRect<RectBestShortSideFitScore>
+};
 
-Guillotine2d::Guillotine2d(int width, int height)
+const Guillotine2d::SplitFunction Guillotine2d::splitFunctions[] = {
+	&Guillotine2d::splitFreeRectByHeuristic<RectSplitShorterLeftoverAxis>,
+	&Guillotine2d::splitFreeRectByHeuristic<RectSplitLongerLeftoverAxis>,
+	&Guillotine2d::splitFreeRectByHeuristic<RectSplitShorterAxis>,
+	&Guillotine2d::splitFreeRectByHeuristic<RectSplitLongerAxis>
+};
+
+
+Guillotine2d::Guillotine2d(int width, int height) :
+	mergeEnabled(false), mergeCount(0)
 {
 	init(width, height);
 }
@@ -20,6 +36,7 @@ void Guillotine2d::init(int width, int height)
 	binHeight = height;
 
 	usedRectangles.clear();
+	mergeCount = 0;
 
 	// Start with a single big free rectangle that spans the whole bin
 	Rect n;
@@ -33,170 +50,165 @@ void Guillotine2d::init(int width, int height)
 }
 
 Rect Guillotine2d::insert(const Rect& rect,
-		FreeRectChoiceHeuristic rectChoice,
-		GuillotineSplitHeuristic splitMethod)
+		FreeRectChoiceHeuristic rectChoice)
 {
-	// Find where to put the new rectangle
-	Rect newRect = findPositionForNewRect(rect, rectChoice);
+	assert(rectChoice >= 0 && rectChoice <= RectBestShortSideFit);
 
-	// Abort if we didn't have enough space in the bin
-	if (newRect.isPlaced == false)
-		return newRect;
-
-	return newRect;
+	// Find where to put the new rectangle
+	int chosen;
+	return (this->*findPositionFunctions[rectChoice])(&rect, 1, &chosen);
 }
 
 void Guillotine2d::insertOnPosition(const Rect& rect, GuillotineSplitHeuristic splitMethod)
 {
-	// Remove the space that was just consumed by the new rectangle.
-	splitFreeRectByHeuristic(freeRectangles[rect.freeRectIndex], rect, splitMethod);
+	// Remove the space that was just consumed by the new rectangle, before
+	// its leftovers are added (and possibly merged).
+	assert(splitMethod >= 0 && splitMethod <= SplitLongerAxis);
+	const Rect freeRect = freeRectangles[rect.freeRectIndex];
 	freeRectangles.erase(freeRectangles.begin() + rect.freeRectIndex);
+	(this->*splitFunctions[splitMethod])(freeRect, rect);
 
 	// Remember the new used rectangle
 	usedRectangles.push_back(rect);
 }
 
-Rect Guillotine2d::findPositionForNewRect(const Rect& rect,
-		FreeRectChoiceHeuristic rectChoice) const
+Rect Guillotine2d::insertFirstFitting(const Rect* rects, int count,
+		FreeRectChoiceHeuristic rectChoice,
+		GuillotineSplitHeuristic splitMethod, int* chosen)
 {
-	int width = rect.width;
-	int height = rect.height;
-	Rect bestRect;
+	assert(rectChoice >= 0 && rectChoice <= RectBestShortSideFit);
+	assert(count <= maxFirstFittingRects);
+
+	Rect newRect = (this->*findPositionFunctions[rectChoice])(rects, count,
+			chosen);
+	if (newRect.isPlaced)
+		insertOnPosition(newRect, splitMethod);
+	return newRect;
+}
 
-	int bestScore = std::numeric_limits<int>::max();
+template <class Score>
+Rect Guillotine2d::findPositionForNewRect(const Rect* rects, int count,
+		int* chosen) const
+{
+	// The best position of every rectangle, as if it was searched alone. A
+	// rectangle is done after a perfect fit, the later ones do not matter
+	// as soon as an earlier one is placed.
+	Rect bestRects[maxFirstFittingRects];
+	int bestScores[maxFirstFittingRects];
+	bool done[maxFirstFittingRects];
+	for (int r = 0; r < count; ++r)
+	{
+		bestScores[r] = std::numeric_limits<int>::max();
+		done[r] = false;
+	}
 
 	// Try each free rectangle to find the best one for placement
-	for (unsigned i = 0; i < freeRectangles.size(); ++i)
+	for (unsigned i = 0; i < freeRectangles.size() && count > 0 && !done[0]; ++i)
 	{
-		// If this is a perfect fit upright, choose it immediately.
-		if (width == freeRectangles[i].width &&
-			height == freeRectangles[i].height)
+		for (int r = 0; r < count; ++r)
 		{
-			bestRect.isPlaced = true;
-			bestRect.x = freeRectangles[i].x;
-			bestRect.y = freeRectangles[i].y;
-			bestRect.width = width;
-			bestRect.height = height;
-			bestScore = std::numeric_limits<int>::min();
-			bestRect.freeRectIndex = i;
-			break;
-		}
-		// If this is a perfect fit sideways, choose it.
-		else if (height == freeRectangles[i].width &&
-				width == freeRectangles[i].height)
-		{
-			bestRect.isPlaced = true;
-			bestRect.x = freeRectangles[i].x;
-			bestRect.y = freeRectangles[i].y;
-			bestRect.width = height;
-			bestRect.height = width;
-			bestScore = std::numeric_limits<int>::min();
-			bestRect.freeRectIndex = i;
-			break;
-		}
-		// Does the rectangle fit upright?
-		if (width <= freeRectangles[i].width &&
-			height <= freeRectangles[i].height)
-		{
-			int score = scoreByHeuristic(rect, freeRectangles[i], rectChoice);
+			if (done[r])
+				continue;
+
+			const Rect& rect = rects[r];
+			const int width = rect.width;
+			const int height = rect.height;
+			Rect& bestRect = bestRects[r];
+			int& bestScore = bestScores[r];
 
-			if (score < bestScore)
+			// If this is a perfect fit upright, choose it immediately.
+			if (width == freeRectangles[i].width &&
+				height == freeRectangles[i].height)
 			{
 				bestRect.isPlaced = true;
 				bestRect.x = freeRectangles[i].x;
 				bestRect.y = freeRectangles[i].y;
 				bestRect.width = width;
 				bestRect.height = height;
-				bestScore = score;
+				bestScore = std::numeric_limits<int>::min();
 				bestRect.freeRectIndex = i;
+				done[r] = true;
 			}
-		}
-		// Does the rectangle fit sideways?
-		if (height <= freeRectangles[i].width &&
-				width <= freeRectangles[i].height)
-		{
-			int score = scoreByHeuristic(rect, freeRectangles[i], rectChoice);
-
-			if (score < bestScore)
+			// If this is a perfect fit sideways, choose it.
+			else if (height == freeRectangles[i].width &&
+					width == freeRectangles[i].height)
 			{
 				bestRect.isPlaced = true;
 				bestRect.x = freeRectangles[i].x;
 				bestRect.y = freeRectangles[i].y;
 				bestRect.width = height;
 				bestRect.height = width;
-				bestScore = score;
+				bestScore = std::numeric_limits<int>::min();
 				bestRect.freeRectIndex = i;
+				done[r] = true;
+			}
+			else
+			{
+				// Does the rectangle fit upright?
+				if (width <= freeRectangles[i].width &&
+					height <= freeRectangles[i].height)
+				{
+					int score = Score::score(rect, freeRectangles[i]);
+
+					if (score < bestScore)
+					{
+						bestRect.isPlaced = true;
+						bestRect.x = freeRectangles[i].x;
+						bestRect.y = freeRectangles[i].y;
+						bestRect.width = width;
+						bestRect.height = height;
+						bestScore = score;
+						bestRect.freeRectIndex = i;
+					}
+				}
+				// Does the rectangle fit sideways?
+				if (height <= freeRectangles[i].width &&
+						width <= freeRectangles[i].height)
+				{
+					int score = Score::score(rect, freeRectangles[i]);
+
+					if (score < bestScore)
+					{
+						bestRect.isPlaced = true;
+						bestRect.x = freeRectangles[i].x;
+						bestRect.y = freeRectangles[i].y;
+						bestRect.width = height;
+						bestRect.height = width;
+						bestScore = score;
+						bestRect.freeRectIndex = i;
+					}
+				}
+			}
+
+			if (bestRect.isPlaced)
+			{
+				count = r + 1;
+				break;
 			}
 		}
 	}
-	return bestRect;
-}
 
-int Guillotine2d::scoreByHeuristic(const Rect& rect, const Rect& freeRect,
-		FreeRectChoiceHeuristic rectChoice)
-{
-	switch(rectChoice)
+	for (int r = 0; r < count; ++r)
 	{
-		case RectBestAreaFit: return scoreBestAreaFit(rect, freeRect);
-		case RectBestShortSideFit: return scoreBestShortSideFit(rect, freeRect);
-		default: assert(false); return std::numeric_limits<int>::max();
+		if (bestRects[r].isPlaced)
+		{
+			*chosen = r;
+			return bestRects[r];
+		}
 	}
+	return Rect();
 }
 
-int Guillotine2d::scoreBestAreaFit(const Rect& rect, const Rect& freeRect)
-{
-	return freeRect.width * freeRect.height - rect.width * rect.height;
-}
-
-int Guillotine2d::scoreBestShortSideFit(const Rect& rect,
-		const Rect& freeRect)
-{
-	int leftoverHoriz = std::abs(freeRect.width - rect.width);
-	int leftoverVert = std::abs(freeRect.height - rect.height);
-	int leftover = std::min(leftoverHoriz, leftoverVert);
-	return leftover;
-}
-
+template <class Split>
 void Guillotine2d::splitFreeRectByHeuristic(const Rect &freeRect,
-		const Rect &placedRect, GuillotineSplitHeuristic method)
+		const Rect &placedRect)
 {
-	// Compute the lengths of the leftover area.
-	const int w = freeRect.width - placedRect.width;
-	const int h = freeRect.height - placedRect.height;
-
 	// Placing placedRect into freeRect results in an L-shaped free area, which
 	// must be split into two disjoint rectangles. This can be achieved with by
 	// splitting the L-shape using a single line.
 	// We have two choices: horizontal or vertical.
-
-	// Use the given heuristic to decide which choice to make.
-
-	bool splitHorizontal;
-	switch(method)
-	{
-	case SplitShorterLeftoverAxis:
-		// Split along the shorter leftover axis.
-		splitHorizontal = (w <= h);
-		break;
-	case SplitLongerLeftoverAxis:
-		// Split along the longer leftover axis.
-		splitHorizontal = (w > h);
-		break;
-	case SplitShorterAxis:
-		// Split along the shorter total axis.
-		splitHorizontal = (freeRect.width <= freeRect.height);
-		break;
-	case SplitLongerAxis:
-		// Split along the longer total axis.
-		splitHorizontal = (freeRect.width > freeRect.height);
-		break;
-	default:
-		splitHorizontal = true;
-		assert(false);
-	}
-
-	// Perform the actual split.
-	splitFreeRectAlongAxis(freeRect, placedRect, splitHorizontal);
+	splitFreeRectAlongAxis(freeRect, placedRect,
+			Split::splitHorizontal(freeRect, placedRect));
 }
 
 
@@ -228,8 +240,81 @@ void Guillotine2d::splitFreeRectAlongAxis(const Rect& freeRect,
 	// Add the new rectangles into the free rectangle pool if they weren't
 	// degenerate.
 	if (bottom.width > 0 && bottom.height > 0)
-		freeRectangles.push_back(bottom);
+		addFreeRect(bottom);
 	if (right.width > 0 && right.height > 0)
-		freeRectangles.push_back(right);
+		addFreeRect(right);
+
+}
+
+bool Guillotine2d::canInsert(const Rect& rect) const
+{
+	for (const Rect& freeRect : freeRectangles)
+	{
+		if ((rect.width <= freeRect.width && rect.height <= freeRect.height) ||
+			(rect.height <= freeRect.width && rect.width <= freeRect.height))
+			return true;
+	}
+	return false;
+}
+
+void Guillotine2d::release()
+{
+	std::pmr::vector<Rect>(usedRectangles.get_allocator()).swap(usedRectangles);
+	std::pmr::vector<Rect>(freeRectangles.get_allocator()).swap(freeRectangles);
+}
 
+void Guillotine2d::addFreeRect(Rect freeRect)
+{
+	// Free rectangles of a guillotine bin are disjoint, so a rectangle has
+	// at most one neighbour on every edge. The merged rectangle may share
+	// an edge with another free rectangle, so merging is repeated.
+	bool merged = mergeEnabled;
+	while (merged)
+	{
+		merged = false;
+		for (size_t i = 0; i < freeRectangles.size(); ++i)
+		{
+			if (mergeFreeRects(freeRect, freeRectangles[i]))
+			{
+				freeRectangles.erase(freeRectangles.begin() + i);
+				++mergeCount;
+				merged = true;
+				break;
+			}
+		}
+	}
+	freeRectangles.push_back(freeRect);
+}
+
+bool Guillotine2d::mergeFreeRects(Rect& a, const Rect& b)
+{
+	if (a.width == b.width && a.x == b.x)
+	{
+		if (a.y == b.y + b.height)
+		{
+			a.y -= b.height;
+			a.height += b.height;
+			return true;
+		}
+		if (a.y + a.height == b.y)
+		{
+			a.height += b.height;
+			return true;
+		}
+	}
+	else if (a.height == b.height && a.y == b.y)
+	{
+		if (a.x == b.x + b.width)
+		{
+			a.x -= b.width;
+			a.width += b.width;
+			return true;
+		}
+		if (a.x + a.width == b.x)
+		{
+			a.width += b.width;
+			return true;
+		}
+	}
+	return false;
 }
@@ -4,346 +4,431 @@
 // Version     : 1.0
 //============================================================================
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
 
 #include "../include/guillotine3d.hpp"
+#include "../include/global_search.hpp"
+#include "../include/guillotine_policies.hpp"
 
 using namespace std;
 
-Guillotine3d::Guillotine3d(int width, int depth)
+// Every heuristic is compiled once for every coordinate type, in the order
+// of the enums.
+template <class T>
+const typename BasicGuillotine3d<T>::FindPositionFunction
+BasicGuillotine3d<T>::findPositionFunctions[] = {
+	&BasicGuillotine3d::template findPositionForNewNode<CuboidMinHeightScore>,
+	&BasicGuillotine3d::template findPositionForNewNode<CuboidBestVolumeFitScore>,
+	&BasicGuillotine3d::template findPositionForNewNode<CuboidBestShortSideFitScore>,
+	&BasicGuillotine3d::template findPositionForNewNode<CuboidContactAreaScore>
+};
+
+template <class T>
+const typename BasicGuillotine3d<T>::SplitFunction
+BasicGuillotine3d<T>::splitFunctions[] = {
+	&BasicGuillotine3d::template splitFreeCuboidByHeuristic<CuboidSplitShorterLeftoverAxis>,
+	&BasicGuillotine3d::template splitFreeCuboidByHeuristic<CuboidSplitLongerLeftoverAxis>,
+	&BasicGuillotine3d::template splitFreeCuboidByHeuristic<CuboidSplitShorterAxis>,
+	&BasicGuillotine3d::template splitFreeCuboidByHeuristic<CuboidSplitLongerAxis>
+};
+
+template <class T>
+BasicGuillotine3d<T>::BasicGuillotine3d(int width, int depth)
 {
 	init(width, depth);
 }
 
-void Guillotine3d::init(int width, int depth)
+template <class T>
+void BasicGuillotine3d<T>::init(int width, int depth)
 {
 	binWidth = width;
 	binHeight = std::numeric_limits<int>::max();
 	binDepth = depth;
 
-	usedCuboids.clear();
+	placements.clear();
+	filledHeight = -1;
 
 	// Fill a whole bin with a big cuboid
-	Cuboid n;
+	BasicFreeCuboid<T> n;
 	n.x = 0;
 	n.y = 0;
 	n.z = 0;
 	n.width = width;
 	n.depth = depth;
-	n.height = std::numeric_limits<int>::max();
+	n.height = BasicFreeCuboid<T>::unboundedHeight();
+	n.unbounded = true;
 
 	freeCuboids.clear();
-	freeCuboids.push_back(n);
+	freeCuboidIndex.clear();
+	freeCuboidFaces.clear();
+	nextSeq = 0;
+	compactionStats = CompactionStats();
+	discardMarks();
+	addFreeCuboid(n);
 }
 
-Cuboid Guillotine3d::insert(const Cuboid& cuboid,
-		FreeCuboidChoiceHeuristic cuboidChoice,
-		GuillotineSplitHeuristic splitMethod)
+template <class T>
+void BasicGuillotine3d<T>::addFreeCuboid(const BasicFreeCuboid<T>& freeCuboid)
 {
-	// Find where to put the new cuboid
-	int freeNodeIndex = 0;
-	Cuboid newCuboid = findPositionForNewNode(cuboid, cuboidChoice, &freeNodeIndex);
-
-	// Abort if we didn't have enough space in the bin
-	if (newCuboid.isPlaced == false)
-		return newCuboid;
-
-	// Remove the space that was just consumed by the new cuboid
-	splitFreeCuboidByHeuristic(freeCuboids[freeNodeIndex], newCuboid, splitMethod);
-	freeCuboids.erase(freeCuboids.begin() + freeNodeIndex);
+	BasicFreeCuboid<T> c = freeCuboid;
+	if (compactionEnabled)
+	{
+		// Degenerate free cuboids have no volume, no cuboid fits into them.
+		if (c.width <= 0 || c.height <= 0 || c.depth <= 0)
+		{
+			++compactionStats.degenerateDropped;
+			return;
+		}
 
-	// Remember the new used cuboid
-	usedCuboids.push_back(newCuboid);
+		// Merge with neighbours as long as they share a full face.
+		unsigned neighbourSlot;
+		while (freeCuboidFaces.findNeighbour(c, &neighbourSlot))
+		{
+			const BasicFreeCuboid<T> neighbour = freeCuboids[neighbourSlot];
+			removeFreeCuboid(neighbourSlot);
+			c = mergeFreeCuboids(c, neighbour);
+			++compactionStats.merged;
+		}
+	}
 
-	return newCuboid;
+	const unsigned slot = freeCuboids.size();
+	if (journalEnabled)
+		journal.push_back(JournalEntry{true, slot, nextSeq, c});
+	freeCuboids.push_back(c, nextSeq);
+	freeCuboidIndex.insert(c, nextSeq, slot);
+	if (compactionEnabled)
+		freeCuboidFaces.insert(c, slot);
+	++nextSeq;
 }
 
-Cuboid Guillotine3d::findPositionForNewNode(const Cuboid& cuboid,
-		FreeCuboidChoiceHeuristic cuboidChoice, int* nodeIndex) const
+template <class T>
+void BasicGuillotine3d<T>::removeFreeCuboid(int index)
 {
-	float width = cuboid.width;
-	float height = cuboid.height;
-	float depth = cuboid.depth;
-	Cuboid bestNode;
+	const BasicFreeCuboid<T> c = freeCuboids[index];
+	if (journalEnabled)
+		journal.push_back(JournalEntry{false, unsigned(index),
+				freeCuboids.getSeq(index), c});
+	freeCuboidIndex.erase(c, freeCuboids.getSeq(index));
+	if (compactionEnabled)
+		freeCuboidFaces.erase(c);
+
+	// The last free cuboid is moved into the removed slot.
+	freeCuboids.erase(index);
+	if (index < (int)freeCuboids.size())
+	{
+		const BasicFreeCuboid<T> moved = freeCuboids[index];
+		freeCuboidIndex.setSlot(moved, freeCuboids.getSeq(index), index);
+		if (compactionEnabled)
+			freeCuboidFaces.setSlot(moved, index);
+	}
+}
 
-	float bestScore = std::numeric_limits<float>::max();
+template <class T>
+typename BasicGuillotine3d<T>::Mark BasicGuillotine3d<T>::mark()
+{
+	journalEnabled = true;
+	return Mark{journal.size(), placements.size(), filledHeight, nextSeq,
+			compactionStats};
+}
 
-	// Try each free cuboid to find the best one for placement a given cuboid.
-	// Rotate a cuboid in every possible way and find which choice is the best.
+template <class T>
+void BasicGuillotine3d<T>::rollback(const Mark& mark)
+{
+	assert(journalEnabled && mark.journal <= journal.size());
 
-	for (unsigned i = 0; i < freeCuboids.size(); ++i)
+	// Undo changes of free cuboids in the reverse order, so every slot gets
+	// back the free cuboid it had.
+	while (journal.size() > mark.journal)
 	{
-		// Width x Height x Depth
-		if (width <= freeCuboids[i].width &&
-			height <= freeCuboids[i].height &&
-			depth <= freeCuboids[i].depth)
-		{
-			float score = scoreByHeuristic(cuboid, freeCuboids[i], cuboidChoice);
-			if (score < bestScore)
-			{
-				bestNode.isPlaced = true;
-				bestNode.x = freeCuboids[i].x;
-				bestNode.y = freeCuboids[i].y;
-				bestNode.z = freeCuboids[i].z;
-				bestNode.width = width;
-				bestNode.height = height;
-				bestNode.depth = depth;
-				bestScore = score;
-				*nodeIndex = i;
-			}
-		}
-
-		// Width x Depth x Height
-		if (width <= freeCuboids[i].width &&
-			depth <= freeCuboids[i].height &&
-			height <= freeCuboids[i].depth)
-		{
-			float score = scoreByHeuristic(cuboid, freeCuboids[i], cuboidChoice);
-			if (score < bestScore)
-			{
-				bestNode.isPlaced = true;
-				bestNode.x = freeCuboids[i].x;
-				bestNode.y = freeCuboids[i].y;
-				bestNode.z = freeCuboids[i].z;
-				bestNode.width = width;
-				bestNode.height = depth;
-				bestNode.depth = height;
-				bestScore = score;
-				*nodeIndex = i;
-			}
-		}
-
-		// Depth x Height x Width
-		if (depth <= freeCuboids[i].width &&
-			height <= freeCuboids[i].height &&
-			width <= freeCuboids[i].depth)
+		const JournalEntry& entry = journal.back();
+		if (entry.added)
 		{
-			float score = scoreByHeuristic(cuboid, freeCuboids[i], cuboidChoice);
-			if (score < bestScore)
-			{
-				bestNode.isPlaced = true;
-				bestNode.x = freeCuboids[i].x;
-				bestNode.y = freeCuboids[i].y;
-				bestNode.z = freeCuboids[i].z;
-				bestNode.width = depth;
-				bestNode.height = height;
-				bestNode.depth = width;
-				bestScore = score;
-				*nodeIndex = i;
-			}
+			assert(entry.slot == freeCuboids.size() - 1);
+			freeCuboidIndex.erase(entry.freeCuboid, entry.seq);
+			if (compactionEnabled)
+				freeCuboidFaces.erase(entry.freeCuboid);
+			freeCuboids.pop_back();
 		}
-
-		// Depth x Width x Height
-		if (depth <= freeCuboids[i].width &&
-			width <= freeCuboids[i].height &&
-			height <= freeCuboids[i].depth)
+		else
 		{
-			float score = scoreByHeuristic(cuboid, freeCuboids[i], cuboidChoice);
-			if (score < bestScore)
+			// The free cuboid which was moved into the slot goes back to the
+			// end.
+			if (entry.slot < freeCuboids.size())
 			{
-				bestNode.isPlaced = true;
-				bestNode.x = freeCuboids[i].x;
-				bestNode.y = freeCuboids[i].y;
-				bestNode.z = freeCuboids[i].z;
-				bestNode.width = depth;
-				bestNode.height = width;
-				bestNode.depth = height;
-				bestScore = score;
-				*nodeIndex = i;
+				const BasicFreeCuboid<T> moved = freeCuboids[entry.slot];
+				freeCuboidIndex.setSlot(moved, freeCuboids.getSeq(entry.slot),
+						freeCuboids.size());
+				if (compactionEnabled)
+					freeCuboidFaces.setSlot(moved, freeCuboids.size());
 			}
+			freeCuboids.insert(entry.slot, entry.freeCuboid, entry.seq);
+			freeCuboidIndex.insert(entry.freeCuboid, entry.seq, entry.slot);
+			if (compactionEnabled)
+				freeCuboidFaces.insert(entry.freeCuboid, entry.slot);
 		}
+		journal.pop_back();
+	}
 
-		// Height x Width x Depth
-		if (height <= freeCuboids[i].width &&
-			width <= freeCuboids[i].height &&
-			depth <= freeCuboids[i].depth)
-		{
-			float score = scoreByHeuristic(cuboid, freeCuboids[i], cuboidChoice);
-			if (score < bestScore)
-			{
-				bestNode.isPlaced = true;
-				bestNode.x = freeCuboids[i].x;
-				bestNode.y = freeCuboids[i].y;
-				bestNode.z = freeCuboids[i].z;
-				bestNode.width = height;
-				bestNode.height = width;
-				bestNode.depth = depth;
-				bestScore = score;
-				*nodeIndex = i;
-			}
-		}
+	placements.resize(mark.placements);
+	filledHeight = mark.filledHeight;
+	nextSeq = mark.nextSeq;
+	compactionStats = mark.compactionStats;
+}
 
-		// Height x Depth x Width
-		if (height <= freeCuboids[i].width &&
-			depth <= freeCuboids[i].height &&
-			width <= freeCuboids[i].depth)
-		{
-			float score = scoreByHeuristic(cuboid, freeCuboids[i], cuboidChoice);
-			if (score < bestScore)
-			{
-				bestNode.isPlaced = true;
-				bestNode.x = freeCuboids[i].x;
-				bestNode.y = freeCuboids[i].y;
-				bestNode.z = freeCuboids[i].z;
-				bestNode.width = height;
-				bestNode.height = depth;
-				bestNode.depth = width;
-				bestScore = score;
-				*nodeIndex = i;
-			}
-		}
-	}
-	return bestNode;
+template <class T>
+void BasicGuillotine3d<T>::discardMarks()
+{
+	journalEnabled = false;
+	journal.clear();
 }
 
-float Guillotine3d::scoreByHeuristic(const Cuboid& cuboid,
-		const Cuboid& freeCuboid,
-		FreeCuboidChoiceHeuristic cuboidChoice)
+template <class T>
+BasicFreeCuboid<T> BasicGuillotine3d<T>::mergeFreeCuboids(
+		const BasicFreeCuboid<T>& a, const BasicFreeCuboid<T>& b)
 {
-	switch (cuboidChoice)
+	BasicFreeCuboid<T> merged;
+	merged.x = min(a.x, b.x);
+	merged.y = min(a.y, b.y);
+	merged.z = min(a.z, b.z);
+	merged.width = max(a.x + a.width, b.x + b.width) - merged.x;
+	merged.depth = max(a.z + a.depth, b.z + b.depth) - merged.z;
+	if (a.unbounded || b.unbounded)
 	{
-	case CuboidMinHeight:
-	default:
-		return scoreMinHeight(cuboid, freeCuboid);
-		break;
+		merged.height = BasicFreeCuboid<T>::unboundedHeight();
+		merged.unbounded = true;
 	}
-	return 0;
+	else
+		merged.height = max(a.y + a.height, b.y + b.height) - merged.y;
+	return merged;
+}
+
+template <class T>
+void BasicGuillotine3d<T>::setCompactionEnabled(bool enabled)
+{
+	assert(placements.empty());
+	compactionEnabled = enabled;
+	init(binWidth, binDepth);
 }
 
+template <class T>
+bool BasicGuillotine3d<T>::insert(const BasicItem<T>& item,
+		FreeCuboidChoiceHeuristic cuboidChoice,
+		GuillotineSplitHeuristic splitMethod, BasicPlacement<T>* placement)
+{
+	assert(cuboidChoice >= 0 && cuboidChoice <= CuboidContactArea);
+	assert(splitMethod >= 0 && splitMethod <= SplitLongerAxis);
+
+	// Find where to put the new item
+	int freeNodeIndex = 0;
+	int orientation = 0;
+	// Abort if we didn't have enough space in the bin
+	if (!(this->*findPositionFunctions[cuboidChoice])(item, &freeNodeIndex,
+			&orientation))
+		return false;
+
+	const BasicFreeCuboid<T> freeCuboid = freeCuboids[freeNodeIndex];
+	const BasicPlacement<T> newPlacement = {item.id, uint8_t(orientation),
+			freeCuboid.x, freeCuboid.y, freeCuboid.z};
+	const BasicCuboid<T> newCuboid = newPlacement.cuboid(item);
+
+	// Remove the space that was just consumed by the new item
+	removeFreeCuboid(freeNodeIndex);
+	(this->*splitFunctions[splitMethod])(freeCuboid, newCuboid);
+
+	// Remember the new placement
+	placements.push_back(newPlacement);
+	filledHeight = max(filledHeight, T(newCuboid.y + newCuboid.height));
+
+	if (placement)
+		*placement = newPlacement;
+	return true;
+}
 
-void Guillotine3d::splitFreeCuboidByHeuristic(const Cuboid& freeCuboid,
-		const Cuboid& placedCuboid, GuillotineSplitHeuristic method)
+template <class T>
+template <class Score>
+bool BasicGuillotine3d<T>::findPositionForNewNode(const BasicItem<T>& item,
+		int* nodeIndex, int* orientation) const
 {
-	// Compute the lengths of the leftover area.
-	const int w = freeCuboid.width - placedCuboid.width;
-	const int d = freeCuboid.depth- placedCuboid.depth;
+	if (Score::heightIndexed && heightIndexEnabled)
+		return findPositionMinHeightIndexed(item, nodeIndex, orientation);
+
+	const T edges[3] = {item.width, item.height, item.depth};
+	bool found = false;
 
-	// Use the given heuristic to decide which choice to make.
+	float bestScore = std::numeric_limits<float>::max();
+	unsigned long bestSeq = 0;
+
+	// Try each free cuboid to find the best one for placement a given cuboid.
+	// Rotate a cuboid in every possible way and find which choice is the best.
+	// Fit tests are done for a block of free cuboids at once, only free
+	// cuboids with some fitting orientation are scored. Ties are resolved by
+	// the order in which free cuboids were added.
 
-	bool splitHorizontal;
-	switch(method)
+	for (size_t first = 0; first < freeCuboids.size();
+			first += FreeCuboidStoreBase::maskBlock)
 	{
-	case SplitShorterLeftoverAxis:
-		// Split along the shorter leftover axis.
-		splitHorizontal = (w <= d);
-		break;
-	case SplitLongerLeftoverAxis:
-		// Split along the longer leftover axis.
-		splitHorizontal = (w > d);
-		break;
-	case SplitShorterAxis:
-		// Split along the shorter total axis.
-		splitHorizontal = (freeCuboid.width <= freeCuboid.depth);
-		break;
-	case SplitLongerAxis:
-		// Split along the longer total axis.
-		splitHorizontal = (freeCuboid.width > freeCuboid.depth);
-		break;
-	default:
-		splitHorizontal = true;
-		assert(false);
+		size_t count = min(FreeCuboidStoreBase::maskBlock,
+				freeCuboids.size() - first);
+		uint64_t masks[6];
+		freeCuboids.fitMasks(first, count,
+				item.width, item.height, item.depth, masks);
+
+		uint64_t fitting = masks[0] | masks[1] | masks[2] |
+				masks[3] | masks[4] | masks[5];
+		for (size_t bit = 0; fitting != 0; ++bit, fitting >>= 1)
+		{
+			if ((fitting & 1) == 0)
+				continue;
+
+			const BasicFreeCuboid<T> freeCuboid = freeCuboids[first + bit];
+			const unsigned long seq = freeCuboids.getSeq(first + bit);
+			BasicCuboid<T> node;
+			node.x = freeCuboid.x;
+			node.y = freeCuboid.y;
+			node.z = freeCuboid.z;
+			for (int o = 0; o < 6; ++o)
+			{
+				if (((masks[o] >> bit) & 1) == 0)
+					continue;
+
+				node.width = edges[itemOrientations[o][0]];
+				node.height = edges[itemOrientations[o][1]];
+				node.depth = edges[itemOrientations[o][2]];
+
+				float score = Score::score(item, node, freeCuboid,
+						binWidth, binDepth);
+				if (score < bestScore ||
+					(score == bestScore && seq < bestSeq))
+				{
+					found = true;
+					bestScore = score;
+					bestSeq = seq;
+					*nodeIndex = first + bit;
+					*orientation = o;
+				}
+			}
+		}
 	}
-
-	// Perform the actual split.
-	splitFreeCuboidAlongAxis(freeCuboid, placedCuboid, splitHorizontal);
+	return found;
 }
 
-float Guillotine3d::scoreMinHeight(const Cuboid& cuboid, const Cuboid& freeCuboid)
+template <class T>
+bool BasicGuillotine3d<T>::findPositionMinHeightIndexed(
+		const BasicItem<T>& item, int* nodeIndex, int* orientation) const
 {
-	return freeCuboid.y + cuboid.height;
+	unsigned slot;
+	if (!freeCuboidIndex.findMinHeight(item, &slot))
+		return false;
+	*nodeIndex = slot;
+
+	*orientation = firstFittingOrientation(item, freeCuboids[*nodeIndex]);
+	assert(*orientation >= 0);
+	return true;
 }
 
-int Guillotine3d::getFilledBinHeight()
+template <class T>
+int BasicGuillotine3d<T>::firstFittingOrientation(const BasicItem<T>& item,
+		const BasicFreeCuboid<T>& freeCuboid)
 {
-	vector<Cuboid> usedCuboids = getUsedCuboids();
-	int max = -1;
-	for (Cuboid c : usedCuboids)
+	const T edges[3] = {item.width, item.height, item.depth};
+
+	for (int o = 0; o < 6; ++o)
 	{
-		int height = c.y + c.height;
-		if (height > max)
-			max = height;
+		if (edges[itemOrientations[o][0]] <= freeCuboid.width &&
+			edges[itemOrientations[o][1]] <= freeCuboid.height &&
+			edges[itemOrientations[o][2]] <= freeCuboid.depth)
+			return o;
 	}
-	return max;
+	return -1;
+}
+
+template <class T>
+template <class Split>
+void BasicGuillotine3d<T>::splitFreeCuboidByHeuristic(
+		const BasicFreeCuboid<T>& freeCuboid, const BasicCuboid<T>& placedCuboid)
+{
+	splitFreeCuboidAlongAxis(freeCuboid, placedCuboid,
+			Split::splitHorizontal(freeCuboid, placedCuboid));
 }
 
-vector<Cuboid> Guillotine3d::insertVector(const std::vector<Cuboid>& cuboids,
+template <class T>
+void BasicGuillotine3d<T>::insertVector(const std::vector<BasicItem<T> >& items,
 		FreeCuboidChoiceHeuristic cuboidChoice,
-		GuillotineSplitHeuristic splitMethod)
+		GuillotineSplitHeuristic splitMethod, PlacementSink* sink)
 {
-    vector<Cuboid> foundPlaces;
-    for (Cuboid c : cuboids)
+    BasicPlacement<T> placement;
+    for (const BasicItem<T>& item : items)
     {
-    	Cuboid place = insert(c, cuboidChoice, splitMethod);
-    	if (place.isPlaced == true)
+    	if (insert(item, cuboidChoice, splitMethod, &placement))
     	{
-    	    c.x = place.x + (0.5 * place.width);
-    	    c.z = place.z + (0.5 * place.depth);
-    	    c.y = place.y + 0.5 * place.height;
-    	    c.width = place.width;
-    	    c.height = place.height;
-    	    c.depth = place.depth;
-    		foundPlaces.push_back(c);
+    		if (sink)
+    			sink->place(Cuboid(placement.cuboid(item)));
     	}
     	else
     	{
     		cout << "Place not found!:" << endl;
-        	cout << "Width: " << c.width << endl;
-        	cout << "Height: " << c.depth<< endl;
+        	cout << "Width: " << item.width << endl;
+        	cout << "Height: " << item.depth<< endl;
 
     	}
     }
-    return foundPlaces;
 }
 
-void Guillotine3d::insertBestGlobal(std::vector<Cuboid> cuboids,
+template <class T>
+void BasicGuillotine3d<T>::insertBestGlobal(std::vector<BasicItem<T> > items,
 		FreeCuboidChoiceHeuristic cuboidChoice,
 		GuillotineSplitHeuristic splitMethod)
 {
-	sort(cuboids.begin(), cuboids.end());
-	int bestScore = numeric_limits<int>::max();
-	while(next_permutation(cuboids.begin(), cuboids.end()))
-	{
-		Guillotine3d guillotine(this->binWidth, this->binDepth);
-		guillotine.insertVector(cuboids,
-				cuboidChoice, splitMethod);
-		int score = guillotine.getFilledBinHeight();
-		if (score < bestScore)
-		{
-			bestScore = score;
-			this->freeCuboids = guillotine.getFreeCuboids();
-			this->usedCuboids = guillotine.getUsedCuboids();
-		}
-	}
+	init(binWidth, binDepth);
+	BasicGlobalSearch<T> search(*this, cuboidChoice, splitMethod);
+	*this = search.branchAndBound(items);
 }
 
-void Guillotine3d::splitFreeCuboidAlongAxis(const Cuboid& freeCuboid,
-		const Cuboid& placedCuboid, bool splitHorizontal)
+template <class T>
+void BasicGuillotine3d<T>::insertBeamGlobal(std::vector<BasicItem<T> > items,
+		FreeCuboidChoiceHeuristic cuboidChoice,
+		GuillotineSplitHeuristic splitMethod, unsigned beamWidth)
+{
+	init(binWidth, binDepth);
+	BasicGlobalSearch<T> search(*this, cuboidChoice, splitMethod);
+	*this = search.beamSearch(items, beamWidth);
+}
+
+template <class T>
+void BasicGuillotine3d<T>::splitFreeCuboidAlongAxis(
+		const BasicFreeCuboid<T>& freeCuboid, const BasicCuboid<T>& placedCuboid,
+		bool splitHorizontal)
 {
 	/* Form the three new cuboids. Two of them (bottom and right) are placed on
 	 * the same level as placed cuboid and their height is the same as for
 	 * placedCuboid. The third one (top) is placed on top of bottom and right
 	 * cuboid and has a base area the same as freeCuboid base. */
 
-	Cuboid bottom;
+	BasicFreeCuboid<T> bottom;
 	bottom.x = freeCuboid.x;
 	bottom.y = freeCuboid.y;
 	bottom.z = freeCuboid.z + placedCuboid.depth;
 	bottom.depth= freeCuboid.depth- placedCuboid.depth;
 	bottom.height = placedCuboid.height;
 
-	Cuboid right;
+	BasicFreeCuboid<T> right;
 	right.x = freeCuboid.x + placedCuboid.width;
 	right.y = freeCuboid.y;
 	right.z = freeCuboid.z;
 	right.width = freeCuboid.width - placedCuboid.width;
 	right.height = placedCuboid.height;
 
-	Cuboid top;
+	BasicFreeCuboid<T> top;
 	top.x = freeCuboid.x;
 	top.y = freeCuboid.y + placedCuboid.height;
 	top.z = freeCuboid.z;
-	if (freeCuboid.height == std::numeric_limits<int>::max())
+	if (freeCuboid.unbounded)
 	{
 		top.height = freeCuboid.height;
+		top.unbounded = true;
 	}
 	else
 	{
@@ -364,8 +449,12 @@ void Guillotine3d::splitFreeCuboidAlongAxis(const Cuboid& freeCuboid,
 	}
 
 	// Add new free cuboids.
-	freeCuboids.push_back(bottom);
-	freeCuboids.push_back(right);
-	freeCuboids.push_back(top);
+	addFreeCuboid(bottom);
+	addFreeCuboid(right);
+	addFreeCuboid(top);
 
 }
+
+template class BasicGuillotine3d<float>;
+template class BasicGuillotine3d<int32_t>;
+template class BasicGuillotine3d<int16_t>;
@@ -0,0 +1,16 @@
+//============================================================================
+// Name        : item.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include "../include/item.hpp"
+
+const int itemOrientations[6][3] = {
+	{0, 1, 2}, // Width x Height x Depth
+	{0, 2, 1}, // Width x Depth x Height
+	{2, 1, 0}, // Depth x Height x Width
+	{2, 0, 1}, // Depth x Width x Height
+	{1, 0, 2}, // Height x Width x Depth
+	{1, 2, 0}  // Height x Depth x Width
+};
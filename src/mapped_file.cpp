@@ -0,0 +1,78 @@
+//============================================================================
+// Name        : mapped_file.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+#include "../include/mapped_file.hpp"
+
+using namespace std;
+
+bool MappedFile::open(const char* filename)
+{
+	close();
+	error.clear();
+
+#if defined(__unix__) || defined(__APPLE__)
+	int fd = ::open(filename, O_RDONLY);
+	struct stat status;
+	if (fd < 0 || fstat(fd, &status) != 0)
+	{
+		if (fd >= 0)
+			::close(fd);
+		error = string("can not open ") + filename;
+		return false;
+	}
+
+	// An empty file can not be mapped.
+	fileSize = status.st_size;
+	if (fileSize > 0)
+	{
+		void* memory = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (memory == MAP_FAILED)
+		{
+			::close(fd);
+			fileSize = 0;
+			error = string("can not map ") + filename;
+			return false;
+		}
+		madvise(memory, fileSize, MADV_SEQUENTIAL);
+		fileData = static_cast<const char*>(memory);
+		mapped = true;
+	}
+	::close(fd);
+#else
+	ifstream in(filename, ios::binary);
+	if (!in.good())
+	{
+		error = string("can not open ") + filename;
+		return false;
+	}
+	buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	fileData = buffer.data();
+	fileSize = buffer.size();
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+#if defined(__unix__) || defined(__APPLE__)
+	if (mapped)
+		munmap(const_cast<char*>(fileData), fileSize);
+#endif
+	mapped = false;
+	buffer.clear();
+	fileData = 0;
+	fileSize = 0;
+}
@@ -0,0 +1,273 @@
+//============================================================================
+// Name        : packer.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+#include <memory_resource>
+
+#include "../include/global_search.hpp"
+#include "../include/packer.hpp"
+
+using namespace std;
+
+namespace {
+
+template <class T>
+void printCompactionStats(const BasicGuillotine3d<T>& bin, ostream& out)
+{
+	const Guillotine3dBase::CompactionStats& stats = bin.getCompactionStats();
+	out << "Free cuboids: " << bin.getUncompactedFreeCuboidCount()
+		<< " before compaction, " << bin.getFreeCuboids().size()
+		<< " after (" << stats.degenerateDropped << " degenerate dropped, "
+		<< stats.merged << " merged)" << endl;
+}
+
+/* Items of cuboids, the id of an item is the position of its cuboid. */
+template <class T>
+void makeItems(const vector<Cuboid>& cuboids, vector<BasicItem<T> >& items)
+{
+	items.clear();
+	for (size_t i = 0; i < cuboids.size(); ++i)
+		items.push_back(BasicItem<T>(i, T(cuboids[i].width),
+				T(cuboids[i].height), T(cuboids[i].depth)));
+}
+
+/* Sink passing cuboids of placed items on with ids of the input cuboids,
+ * the id of an item is the position of its cuboid. */
+class InputIdSink : public PlacementSink {
+public:
+	InputIdSink(const vector<Cuboid>& cuboids, PlacementSink* sink) :
+		cuboids(cuboids), sink(sink) {}
+
+	void place(const Cuboid& cuboid) override
+	{
+		Cuboid placed = cuboid;
+		placed.id = cuboids[cuboid.id].id;
+		sink->place(placed);
+	}
+
+private:
+	const vector<Cuboid>& cuboids;
+	PlacementSink* sink;
+};
+
+class ShelfPacker : public Packer {
+public:
+	ShelfPacker(int width, int depth, const Options& options) :
+		options(options), width(width), depth(depth),
+		shelfAlg(width, depth, &pool)
+	{
+		shelfAlg.setMergeEnabled(options.compaction);
+	}
+
+	void reset(int width, int depth) override
+	{
+		this->width = width;
+		this->depth = depth;
+		shelfAlg.init(width, depth);
+	}
+
+	size_t pack(const vector<Cuboid>& cuboids, PlacementSink* sink) override
+	{
+		sorted.assign(cuboids.begin(), cuboids.end());
+		sort(sorted.begin(), sorted.end(), &Cuboid::compareVolume);
+
+		shelfAlg.init(width, depth);
+		shelfAlg.setPlacementSink(sink);
+		size_t notPlaced = 0;
+		if (options.threads > 1)
+			// A height class for every thread
+			notPlaced = shelfAlg.insertParallel(sorted, options.shelfChoice,
+					options.threads, options.threads);
+		else
+			for (const Cuboid& cuboid : sorted)
+				if (!shelfAlg.insert(cuboid, options.shelfChoice).isPlaced)
+					++notPlaced;
+		shelfAlg.setPlacementSink(0);
+		return notPlaced;
+	}
+
+	const vector<Cuboid>& getPlacedCuboids() const override
+	{
+		return shelfAlg.getUsedCuboids();
+	}
+
+	float getFilledBinHeight() const override
+	{
+		return shelfAlg.getFilledBinHeight();
+	}
+
+	void printStats(ostream& out) const override
+	{
+		if (options.compaction)
+			out << "Free rectangles merged: " << shelfAlg.getMergeCount()
+				<< endl;
+	}
+
+private:
+	Options options;
+	int width;
+	int depth;
+	/* Shelves and their free rectangles return to the pool on reset. */
+	std::pmr::unsynchronized_pool_resource pool;
+	ShelfAlgorithm shelfAlg;
+	vector<Cuboid> sorted;
+};
+
+template <class T>
+class GuillotinePacker : public Packer {
+public:
+	GuillotinePacker(int width, int depth, const Options& options) :
+		options(options), bin(width, depth)
+	{
+		bin.setCompactionEnabled(options.compaction);
+	}
+
+	void reset(int width, int depth) override
+	{
+		bin.init(width, depth);
+	}
+
+	size_t pack(const vector<Cuboid>& cuboids, PlacementSink* sink) override
+	{
+		sorted.assign(cuboids.begin(), cuboids.end());
+		for (size_t i = 0; i < sorted.size(); ++i)
+			sorted[i].id = i;
+		sort(sorted.begin(), sorted.end(), &Cuboid::compareMaxEdge);
+
+		items.clear();
+		for (const Cuboid& cuboid : sorted)
+			items.push_back(BasicItem<T>(cuboid));
+		bin.init(bin.getBinWidth(), bin.getBinDepth());
+		InputIdSink inputIdSink(cuboids, sink);
+		bin.insertVector(items, options.cuboidChoice,
+				Guillotine3dBase::SplitLongerLeftoverAxis,
+				sink ? &inputIdSink : 0);
+
+		placedCuboids(bin, cuboids, placed);
+		return cuboids.size() - placed.size();
+	}
+
+	const vector<Cuboid>& getPlacedCuboids() const override
+	{
+		return placed;
+	}
+
+	float getFilledBinHeight() const override
+	{
+		return bin.getFilledBinHeight();
+	}
+
+	void printStats(ostream& out) const override
+	{
+		if (options.compaction)
+			printCompactionStats(bin, out);
+	}
+
+private:
+	Options options;
+	BasicGuillotine3d<T> bin;
+	vector<Cuboid> sorted;
+	vector<BasicItem<T> > items;
+	vector<Cuboid> placed;
+};
+
+class GlobalGuillotinePacker : public Packer {
+public:
+	GlobalGuillotinePacker(int width, int depth, const Options& options) :
+		options(options), emptyBin(width, depth), bin(width, depth),
+		lowerBound(0), visitedNodes(0), optimal(false)
+	{
+		emptyBin.setCompactionEnabled(options.compaction);
+	}
+
+	void reset(int width, int depth) override
+	{
+		emptyBin.init(width, depth);
+		bin.init(width, depth);
+	}
+
+	size_t pack(const vector<Cuboid>& cuboids, PlacementSink* sink) override
+	{
+		// The search sorts items itself.
+		makeItems(cuboids, items);
+		GlobalSearch search(emptyBin, options.cuboidChoice,
+				Guillotine3dBase::SplitLongerLeftoverAxis);
+		if (options.beamWidth > 0)
+			bin = search.beamSearch(items, options.beamWidth);
+		else
+			bin = search.branchAndBound(items, options.nodeLimit,
+					options.threads);
+		lowerBound = search.getLowerBound();
+		visitedNodes = search.getVisitedNodes();
+		optimal = search.isOptimal();
+
+		placedCuboids(bin, cuboids, placed);
+		if (sink)
+			for (const Cuboid& cuboid : placed)
+				sink->place(cuboid);
+		return cuboids.size() - placed.size();
+	}
+
+	const vector<Cuboid>& getPlacedCuboids() const override
+	{
+		return placed;
+	}
+
+	float getFilledBinHeight() const override
+	{
+		return bin.getFilledBinHeight();
+	}
+
+	void printStats(ostream& out) const override
+	{
+		out << "Lower bound: " << lowerBound << ", visited nodes: "
+			<< visitedNodes << ", optimal: "
+			<< (optimal ? "yes" : "not proven") << endl;
+		if (options.compaction)
+			printCompactionStats(bin, out);
+	}
+
+private:
+	Options options;
+	Guillotine3d emptyBin;
+	Guillotine3d bin;
+	vector<Item> items;
+	vector<Cuboid> placed;
+
+	float lowerBound;
+	unsigned long visitedNodes;
+	bool optimal;
+};
+
+} // namespace
+
+unique_ptr<Packer> Packer::create(Engine engine, int width, int depth,
+		const Options& options)
+{
+	switch (engine)
+	{
+	case EngineShelf:
+		return unique_ptr<Packer>(new ShelfPacker(width, depth, options));
+	case EngineGuillotine:
+		if (options.coordinates == CoordinatesInt32)
+			return unique_ptr<Packer>(
+					new GuillotinePacker<int32_t>(width, depth, options));
+		if (options.coordinates == CoordinatesInt16)
+			return unique_ptr<Packer>(
+					new GuillotinePacker<int16_t>(width, depth, options));
+		return unique_ptr<Packer>(
+				new GuillotinePacker<float>(width, depth, options));
+	case EngineGlobalGuillotine:
+		return unique_ptr<Packer>(
+				new GlobalGuillotinePacker(width, depth, options));
+	}
+	return unique_ptr<Packer>();
+}
+
+unique_ptr<Packer> Packer::create(Engine engine, int width, int depth)
+{
+	return create(engine, width, depth, Options());
+}
@@ -0,0 +1,48 @@
+//============================================================================
+// Name        : placement_writer.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <cassert>
+#include <boost/archive/xml_oarchive.hpp>
+
+#include "../include/cuboid_io.hpp"
+#include "../include/placement_writer.hpp"
+
+using namespace std;
+
+PlacementWriter::PlacementWriter(const char* filename, size_t capacity) :
+	ofs(filename), queue(capacity)
+{
+	assert(ofs.good());
+	writer = thread(&PlacementWriter::write, this);
+}
+
+PlacementWriter::~PlacementWriter()
+{
+	if (writer.joinable())
+		finish(Rect());
+}
+
+void PlacementWriter::finish(const Rect& base)
+{
+	// The base is read by the writer after it sees the queue closed.
+	this->base = base;
+	queue.close();
+	writer.join();
+	ofs.close();
+}
+
+void PlacementWriter::write()
+{
+	boost::archive::xml_oarchive oa(ofs);
+	Cuboid placed;
+	while (queue.pop(placed))
+	{
+		Cuboid cuboid = transform(placed);
+		oa << boost::serialization::make_nvp("cuboid", cuboid);
+	}
+	if (base.width != 0 && base.height != 0)
+		oa << boost::serialization::make_nvp("base", base);
+}
@@ -4,207 +4,386 @@
 // Version     : 1.0
 //============================================================================
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <functional>
+#include <iostream>
+#include <thread>
 
 #include "../include/shelf_algorithm.hpp"
 
 using namespace std;
 
-ShelfAlgorithm::ShelfAlgorithm(float width, float depth)
+ShelfAlgorithm::ShelfAlgorithm(float width, float depth,
+		std::pmr::memory_resource* resource) :
+	splitMethod(Guillotine2d::SplitLongerLeftoverAxis), mergeEnabled(false),
+	resource(resource), shelves(resource), shelfIndex(resource),
+	shelvesByHeight(resource), shelvesByArea(resource), placementSink(0)
 {
 	init(width,  depth);
 }
 
-void ShelfAlgorithm::init(float width, float depth)
+void ShelfAlgorithm::init(float width, float depth, float height)
 {
 	binWidth = width;
-	binHeight = numeric_limits<float>::max();
+	binHeight = height;
 	binDepth = depth;
 
 	currentY = 0;
+	filledHeight = -1;
 
 	shelves.clear();
+	usedCuboids.clear();
+	shelfIndex.clear();
+	shelvesByHeight.clear();
+	shelvesByArea.clear();
+	openShelves.clear();
+	maxOpenShelves = 0;
 	startNewShelf(0);
 }
 
 Cuboid ShelfAlgorithm::insert(const Cuboid& cuboid, ShelfChoiceHeuristic method)
 {
+	// Sort edges in increasing order
+	float edges[3] = {cuboid.width, cuboid.height, cuboid.depth};
+	sortEdges(edges);
+	const Orientations orientations(edges);
+
 	Cuboid fittingCuboid;
 	switch(method)
 	{
 	case ShelfNextFit:
-		fittingCuboid = putOnShelf(shelves.back(), cuboid);
+		fittingCuboid = putOnShelf(shelves.back(), cuboid.id, orientations);
 		if (fittingCuboid.isPlaced == true)
 		{
-			addToShelf(shelves.back(), cuboid);
+			addToShelf(shelves.size() - 1, fittingCuboid);
 			return fittingCuboid;
 		}
 		break;
 
 	case ShelfFirstFit:
-		for(size_t i = 0; i < shelves.size(); ++i)
+		// Only shelves which may hold the cuboid are tried.
+		for (size_t i = shelfIndex.findFirst(0, edges); i < shelves.size();
+				i = shelfIndex.findFirst(i + 1, edges))
 		{
-			fittingCuboid = putOnShelf(shelves[i], cuboid);
+			fittingCuboid = putOnShelf(shelves[i], cuboid.id, orientations);
 			if (fittingCuboid.isPlaced == true)
 			{
-				addToShelf(shelves[i], fittingCuboid);
+				addToShelf(i, fittingCuboid);
 				return fittingCuboid;
 			}
 		}
 		break;
-	}
 
-	// The rectangle did not fit on any of the shelves. Open a new shelf.
-
-	// Sort edges in decreasing order
-	vector<float> edges = {cuboid.width, cuboid.height, cuboid.depth};
-	sort(edges.begin(), edges.end());
-	float max = edges[2];
-	float middle = edges[1];
-	float min = edges[0];
-	Cuboid newCuboid(middle, max, min);
+	case ShelfBestHeightFit:
+	case ShelfBestAreaFit:
+	case ShelfWorstAreaFit:
+	{
+		size_t index;
+		fittingCuboid = putOnBestShelf(cuboid.id, edges, orientations, method,
+				&index);
+		if (fittingCuboid.isPlaced == true)
+		{
+			addToShelf(index, fittingCuboid);
+			return fittingCuboid;
+		}
+		break;
+	}
+	}
 
-	if (canStartNewShelf(newCuboid.height))
+	// The rectangle did not fit on any of the shelves. Open a new shelf as
+	// high as the longest edge which fits under the top of the bin.
+	for (int o = 0; o < 3; ++o)
 	{
-		startNewShelf(newCuboid.height);
-		auto fits = putOnShelf(shelves.back(), newCuboid);
-		assert(fits.isPlaced);
-		addToShelf(shelves.back(), fits);
-		return fits;
+		if (canStartNewShelf(orientations.verticals[o]) &&
+			fitsEmptyShelf(orientations.bases[o]))
+		{
+			startNewShelf(orientations.verticals[o]);
+			auto fits = putOnShelf(shelves.back(), cuboid.id, orientations,
+					o, 1);
+			assert(fits.isPlaced);
+			addToShelf(shelves.size() - 1, fits);
+			return fits;
+		}
 	}
 
 	// The rectangle didn't fit.
 	return cuboid;
 }
 
-Cuboid ShelfAlgorithm::putOnShelf(Shelf& shelf, const Cuboid& cuboid)
+ShelfAlgorithm::Orientations::Orientations(const float edges[3])
+{
+	const float max = edges[2];
+	const float middle = edges[1];
+	const float min = edges[0];
+	bases[0] = Rect(middle, min);
+	verticals[0] = max;
+	bases[1] = Rect(min, max);
+	verticals[1] = middle;
+	bases[2] = Rect(middle, max);
+	verticals[2] = min;
+}
+
+Cuboid ShelfAlgorithm::putOnShelf(Shelf& shelf, unsigned id,
+		const Orientations& orientations)
+{
+	// An edge higher than the shelf can not be vertical. Verticals decrease,
+	// so only the first orientations are skipped.
+	const float maxVertical = maxShelfHeight(shelf);
+	int first = 0;
+	while (first < 3 && orientations.verticals[first] > maxVertical)
+		++first;
+
+	return putOnShelf(shelf, id, orientations, first, 3 - first);
+}
+
+Cuboid ShelfAlgorithm::putOnShelf(Shelf& shelf, unsigned id,
+		const Orientations& orientations, int first, int count)
 {
-	float width = cuboid.width;
-	float height = cuboid.height;
-	float depth = cuboid.depth;
 	Cuboid cuboidNotPlaced;
 	cuboidNotPlaced.isPlaced = false;
 
-	// Sort edges in decreasing order
-	vector<float> edges = {width, height, depth};
-	sort(edges.begin(), edges.end());
-	float max = edges[2];
-	float middle = edges[1];
-	float min = edges[0];
+	int chosen;
+	Rect placement = shelf.guillotine.insertFirstFitting(
+			orientations.bases + first, count,
+			Guillotine2d::RectBestAreaFit, splitMethod, &chosen);
+	if (!placement.isPlaced)
+		return cuboidNotPlaced;
+
+	Cuboid c(placement.width, orientations.verticals[first + chosen],
+			placement.height);
+	c.id = id;
+	c.isPlaced = true;
+	c.x = placement.x;
+	c.z = placement.y;
+	return c;
+}
 
-	// Set cuboid's longest egde vertically
-	if (shelf.height > 0 && max > shelf.height)
-	{
-		// pass
-	}
-	else
+Cuboid ShelfAlgorithm::putOnBestShelf(unsigned id, const float edges[3],
+		const Orientations& orientations, ShelfChoiceHeuristic method,
+		size_t* index)
+{
+	Cuboid cuboidNotPlaced;
+	cuboidNotPlaced.isPlaced = false;
+
+	if (method == ShelfBestHeightFit)
 	{
-		Rect maxVerticalRect(middle, min);
-		Rect placement = shelf.guillotine.insert(maxVerticalRect,
-				Guillotine2d::RectBestAreaFit,
-				Guillotine2d::SplitLongerLeftoverAxis);
-		if (placement.isPlaced)
+		// For every edge standing vertically, the lowest shelf not lower
+		// than the edge whose free rectangles fit the base.
+		float bestLeftover = numeric_limits<float>::infinity();
+		int bestOrientation = -1;
+		size_t bestShelf = 0;
+		for (int o = 0; o < 3; ++o)
 		{
-			Cuboid c(placement.width, max, placement.height);
-			shelf.guillotine.insertOnPosition(placement,
-					Guillotine2d::SplitLongerLeftoverAxis);
-			c.isPlaced = true;
-			c.x = placement.x;
-			c.z = placement.y;
-			return c;
+			const float vertical = orientations.verticals[o];
+			const Rect& base = orientations.bases[o];
+			for (auto it = shelvesByHeight.lower_bound(make_pair(vertical,
+					size_t(0))); it != shelvesByHeight.end(); ++it)
+			{
+				// Higher shelves can not leave less height.
+				float leftover = it->first - vertical;
+				if (bestOrientation >= 0 && leftover >= bestLeftover)
+					break;
+
+				const ShelfCapacityIndex::Capacity& c = shelfIndex[it->second];
+				if (std::min(base.width, base.height) > c.maxShortSide ||
+					std::max(base.width, base.height) > c.maxLongSide ||
+					!shelves[it->second].guillotine.canInsert(base))
+					continue;
+
+				bestLeftover = leftover;
+				bestOrientation = o;
+				bestShelf = it->second;
+				break;
+			}
 		}
-	}
-
-
-	// Set cuboid's second longest egde vertically
+		if (bestOrientation < 0)
+			return cuboidNotPlaced;
 
-	if (shelf.height > 0 && middle > shelf.height)
-	{
-		// pass
+		*index = bestShelf;
+		return putOnShelf(shelves[bestShelf], id, orientations,
+				bestOrientation, 1);
 	}
-	else
+
+	// A shelf needs at least the area of the smallest base.
+	const long minArea = long(int(edges[0])) * int(edges[1]);
+	if (method == ShelfBestAreaFit)
 	{
-		Rect middleVerticalRect(min, max);
-		Rect placement = shelf.guillotine.insert(middleVerticalRect,
-				Guillotine2d::RectBestAreaFit,
-				Guillotine2d::SplitLongerLeftoverAxis);
-		if (placement.isPlaced)
+		for (auto it = shelvesByArea.lower_bound(make_pair(minArea,
+				size_t(0))); it != shelvesByArea.end(); ++it)
 		{
-
-			Cuboid c(placement.width, middle, placement.height);
-			shelf.guillotine.insertOnPosition(placement,
-					Guillotine2d::SplitLongerLeftoverAxis);
-			c.isPlaced = true;
-			c.x = placement.x;
-			c.z = placement.y;
-			return c;
+			if (!ShelfCapacityIndex::mayHold(shelfIndex[it->second], edges))
+				continue;
+			Cuboid placed = putOnShelf(shelves[it->second], id, orientations);
+			if (placed.isPlaced)
+			{
+				*index = it->second;
+				return placed;
+			}
 		}
 	}
-
-	// Set cuboid's smallest egde vertically
-
-	if (shelf.height > 0 && min > shelf.height)
-	{
-		// pass
-	}
 	else
 	{
-		Rect minVerticalRect(middle, max);
-		Rect placement = shelf.guillotine.insert(minVerticalRect,
-				Guillotine2d::RectBestAreaFit,
-				Guillotine2d::SplitLongerLeftoverAxis);
-		if (placement.isPlaced)
+		assert(method == ShelfWorstAreaFit);
+		for (auto it = shelvesByArea.rbegin(); it != shelvesByArea.rend() &&
+				it->first >= minArea; ++it)
 		{
-			Cuboid c (placement.width, min, placement.height);
-			shelf.guillotine.insertOnPosition(placement,
-					Guillotine2d::SplitLongerLeftoverAxis);
-			c.isPlaced = true;
-			c.x = placement.x;
-			c.z = placement.y;
-			return c;
+			if (!ShelfCapacityIndex::mayHold(shelfIndex[it->second], edges))
+				continue;
+			Cuboid placed = putOnShelf(shelves[it->second], id, orientations);
+			if (placed.isPlaced)
+			{
+				*index = it->second;
+				return placed;
+			}
 		}
 	}
+	return cuboidNotPlaced;
+}
 
+float ShelfAlgorithm::maxShelfHeight(const Shelf& shelf) const
+{
+	return shelf.height > 0 ? shelf.height : binHeight - shelf.startY;
+}
 
-	return cuboidNotPlaced;
+bool ShelfAlgorithm::fitsEmptyShelf(const Rect& base) const
+{
+	const int width = binWidth;
+	const int depth = binDepth;
+	return (base.width <= width && base.height <= depth) ||
+			(base.height <= width && base.width <= depth);
 }
 
-void ShelfAlgorithm::addToShelf(Shelf& shelf, Cuboid newCuboid)
+void ShelfAlgorithm::addToShelf(size_t index, Cuboid& newCuboid)
 {
+	Shelf& shelf = shelves[index];
+
+	// Keys of the shelf change, its nodes are reused.
+	auto heightNode = shelvesByHeight.extract(make_pair(maxShelfHeight(shelf),
+			index));
+	auto areaNode = shelvesByArea.extract(make_pair(shelf.freeArea, index));
+	assert(!heightNode.empty() && !areaNode.empty());
+
 	// Add the cuboid to the shelf.
 	newCuboid.y = shelf.startY;
 
 	assert(newCuboid.isPlaced);
 	usedCuboids.push_back(newCuboid);
+	if (placementSink)
+		placementSink->place(newCuboid);
+	filledHeight = max(filledHeight, newCuboid.y + newCuboid.height);
+	lastShelf = index;
 
 	// Grow the shelf height.
 	shelf.height = max(shelf.height, newCuboid.height);
 	assert(shelf.height <= binHeight);
+	shelf.freeArea -= long(newCuboid.width) * long(newCuboid.depth);
 
+	shelfIndex.update(index, capacity(shelf));
+	heightNode.value().first = maxShelfHeight(shelf);
+	shelvesByHeight.insert(std::move(heightNode));
+	areaNode.value().first = shelf.freeArea;
+	shelvesByArea.insert(std::move(areaNode));
 }
 
-bool ShelfAlgorithm::canStartNewShelf(float height) const
+void ShelfAlgorithm::pushShelf(Shelf&& shelf)
 {
-	return shelves.back().startY + shelves.back().height + height < binHeight;
+	shelves.push_back(std::move(shelf));
+	const Shelf& added = shelves.back();
+	size_t index = shelves.size() - 1;
+	shelfIndex.push_back(capacity(shelves.back()));
+	shelvesByHeight.insert(make_pair(maxShelfHeight(added), index));
+	shelvesByArea.insert(make_pair(added.freeArea, index));
 }
 
-float ShelfAlgorithm::getFilledBinHeight()
+ShelfCapacityIndex::Capacity ShelfAlgorithm::capacity(const Shelf& shelf) const
 {
-	float max = -1;
-	for (Cuboid c : usedCuboids)
+	// A shelf without a height yet takes a cuboid up to the top of the bin.
+	ShelfCapacityIndex::Capacity c;
+	c.height = maxShelfHeight(shelf);
+	c.maxShortSide = -1;
+	c.maxLongSide = -1;
+	for (const Rect& r : shelf.guillotine.getFreeRectangles())
 	{
-		float height = c.y + c.height;
-		if (height > max)
-			max = height;
+		c.maxShortSide = std::max(c.maxShortSide, std::min(r.width, r.height));
+		c.maxLongSide = std::max(c.maxLongSide, std::max(r.width, r.height));
 	}
-	return max;
+	return c;
+}
+
+bool ShelfAlgorithm::mayHoldAny(const Shelf& shelf, float minShortEdge,
+		float minMiddleEdge) const
+{
+	// The shortest edge is the lowest a cuboid can stand, and its base has
+	// a side not shorter than the shortest edge and one not shorter than the
+	// middle edge. Sides are compared as whole numbers, as by Guillotine2d.
+	ShelfCapacityIndex::Capacity c = capacity(shelf);
+	return minShortEdge <= c.height &&
+			int(minShortEdge) <= c.maxShortSide &&
+			int(minMiddleEdge) <= c.maxLongSide;
+}
+
+void ShelfAlgorithm::closeShelf(size_t index, const ShelfSink& sink)
+{
+	Shelf& shelf = shelves[index];
+	assert(!shelf.closed);
+	shelf.closed = true;
+	shelf.guillotine.release();
+
+	// Nothing fits a closed shelf.
+	ShelfCapacityIndex::Capacity none = {
+		-numeric_limits<float>::infinity(), -1, -1
+	};
+	shelfIndex.update(index, none);
+	shelvesByHeight.erase(make_pair(maxShelfHeight(shelf), index));
+	shelvesByArea.erase(make_pair(shelf.freeArea, index));
+
+	sink(shelf.cuboids);
+	vector<Cuboid>().swap(shelf.cuboids);
+}
+
+bool ShelfAlgorithm::canStartNewShelf(float height) const
+{
+	return shelves.back().startY + shelves.back().height + height <= binHeight;
+}
+
+ShelfCapacityIndex::Capacity ShelfAlgorithm::getNewShelfCapacity() const
+{
+	ShelfCapacityIndex::Capacity c;
+	c.height = binHeight - (shelves.back().startY + shelves.back().height);
+	c.maxShortSide = std::min(int(binWidth), int(binDepth));
+	c.maxLongSide = std::max(int(binWidth), int(binDepth));
+	return c;
+}
+
+void ShelfAlgorithm::setMergeEnabled(bool enabled)
+{
+	assert(usedCuboids.empty());
+	mergeEnabled = enabled;
+	init(binWidth, binDepth, binHeight);
+}
+
+unsigned long ShelfAlgorithm::getMergeCount() const
+{
+	unsigned long merges = 0;
+	for (const Shelf& shelf : shelves)
+		merges += shelf.guillotine.getMergeCount();
+	return merges;
+}
+
+float ShelfAlgorithm::getFilledBinHeight() const
+{
+	return filledHeight;
 }
 
 std::vector<Cuboid> ShelfAlgorithm::insert(const std::vector<Cuboid>& cuboids,
 		ShelfChoiceHeuristic choice)
 {
 	vector<Cuboid> placedCuboids;
-    for (Cuboid c : cuboids)
+	placedCuboids.reserve(cuboids.size());
+	usedCuboids.reserve(usedCuboids.size() + cuboids.size());
+    for (const Cuboid& c : cuboids)
     {
     	Cuboid placed = insert(c, choice);
     	if (placed.isPlaced == true)
@@ -223,6 +402,201 @@ std::vector<Cuboid> ShelfAlgorithm::insert(const std::vector<Cuboid>& cuboids,
     return placedCuboids;
 }
 
+size_t ShelfAlgorithm::insertStreaming(const std::vector<Cuboid>& cuboids,
+		ShelfChoiceHeuristic method, const ShelfSink& sink)
+{
+	// The shortest and the middle edge of the smallest cuboids from the given
+	// one to the end, they only grow while cuboids are inserted.
+	vector<float> minShortEdges(cuboids.size() + 1,
+			numeric_limits<float>::infinity());
+	vector<float> minMiddleEdges(cuboids.size() + 1,
+			numeric_limits<float>::infinity());
+	for (size_t i = cuboids.size(); i-- > 0;)
+	{
+		float edges[3] = {cuboids[i].width, cuboids[i].height, cuboids[i].depth};
+		sortEdges(edges);
+		minShortEdges[i] = min(minShortEdges[i + 1], edges[0]);
+		minMiddleEdges[i] = min(minMiddleEdges[i + 1], edges[1]);
+	}
+
+	openShelves.clear();
+	for (size_t i = 0; i < shelves.size(); ++i)
+		if (!shelves[i].closed)
+			openShelves.push_back(i);
+
+	size_t notPlaced = 0;
+	for (size_t i = 0; i < cuboids.size(); ++i)
+	{
+		size_t shelfCount = shelves.size();
+		Cuboid placed = insert(cuboids[i], method);
+		if (!placed.isPlaced)
+		{
+			++notPlaced;
+			continue;
+		}
+		shelves[lastShelf].cuboids.push_back(usedCuboids.back());
+		usedCuboids.pop_back();
+		if (shelves.size() > shelfCount)
+			openShelves.push_back(shelves.size() - 1);
+		maxOpenShelves = max(maxOpenShelves, openShelves.size());
+		if (i + 1 == cuboids.size())
+			break;
+
+		// Only the shelf which took the cuboid has less space, others may
+		// be closed only if remaining cuboids got bigger.
+		float minShort = minShortEdges[i + 1];
+		float minMiddle = minMiddleEdges[i + 1];
+		if (minShort == minShortEdges[i] && minMiddle == minMiddleEdges[i])
+		{
+			if (!mayHoldAny(shelves[lastShelf], minShort, minMiddle))
+			{
+				closeShelf(lastShelf, sink);
+				openShelves.erase(find(openShelves.begin(), openShelves.end(),
+						lastShelf));
+			}
+			continue;
+		}
+
+		size_t open = 0;
+		for (size_t index : openShelves)
+		{
+			if (mayHoldAny(shelves[index], minShort, minMiddle))
+				openShelves[open++] = index;
+			else
+				closeShelf(index, sink);
+		}
+		openShelves.resize(open);
+	}
+
+	for (size_t index : openShelves)
+		closeShelf(index, sink);
+	openShelves.clear();
+	return notPlaced;
+}
+
+size_t ShelfAlgorithm::insertParallel(const std::vector<Cuboid>& cuboids,
+		ShelfChoiceHeuristic method, unsigned heightClasses, unsigned threads)
+{
+	assert(usedCuboids.empty());
+	heightClasses = std::max(heightClasses, 1u);
+	threads = std::max(1u, std::min(threads, heightClasses));
+
+	// The lowest longest edge of every class but the last one, classes of
+	// higher cuboids first.
+	vector<float> maxEdges(cuboids.size());
+	for (size_t i = 0; i < cuboids.size(); ++i)
+		maxEdges[i] = std::max(cuboids[i].width,
+				std::max(cuboids[i].height, cuboids[i].depth));
+	vector<float> sortedMaxEdges(maxEdges);
+	sort(sortedMaxEdges.begin(), sortedMaxEdges.end(), greater<float>());
+	vector<float> classMinEdges(heightClasses - 1);
+	for (size_t c = 0; c + 1 < heightClasses; ++c)
+	{
+		size_t count = (c + 1) * cuboids.size() / heightClasses;
+		classMinEdges[c] = count == 0 ? numeric_limits<float>::infinity() :
+				sortedMaxEdges[count - 1];
+	}
+
+	// Cuboids of a class keep their order.
+	vector<vector<Cuboid> > classes(heightClasses);
+	for (size_t i = 0; i < cuboids.size(); ++i)
+	{
+		size_t c = 0;
+		while (c < classMinEdges.size() && maxEdges[i] < classMinEdges[c])
+			++c;
+		classes[c].push_back(cuboids[i]);
+	}
+
+	// Every class is packed by its own algorithm, on the first free thread.
+	vector<ShelfAlgorithm> parts(heightClasses);
+	vector<size_t> notPlaced(heightClasses, 0);
+	atomic<unsigned> nextClass(0);
+	auto packClasses = [&]()
+	{
+		for (unsigned c; (c = nextClass++) < heightClasses;)
+		{
+			ShelfAlgorithm& part = parts[c];
+			part.splitMethod = splitMethod;
+			part.mergeEnabled = mergeEnabled;
+			part.init(binWidth, binDepth);
+			for (const Cuboid& cuboid : classes[c])
+				if (!part.insert(cuboid, method).isPlaced)
+					++notPlaced[c];
+		}
+	};
+	if (threads == 1)
+		packClasses();
+	else
+	{
+		vector<thread> pool;
+		for (unsigned t = 0; t < threads; ++t)
+			pool.push_back(thread(packClasses));
+		for (thread& t : pool)
+			t.join();
+	}
+
+	// Stack the shelves of classes but the last ones.
+	shelves.clear();
+	shelfIndex.clear();
+	shelvesByHeight.clear();
+	shelvesByArea.clear();
+	usedCuboids.reserve(cuboids.size());
+	vector<Cuboid> leftovers;
+	float top = 0;
+	for (const ShelfAlgorithm& part : parts)
+	{
+		if (part.usedCuboids.empty())
+			continue;
+
+		for (size_t s = 0; s + 1 < part.shelves.size(); ++s)
+		{
+			Shelf shelf(resource);
+			shelf.startY = top + part.shelves[s].startY;
+			shelf.height = part.shelves[s].height;
+			shelf.guillotine = part.shelves[s].guillotine;
+			shelf.freeArea = part.shelves[s].freeArea;
+			shelf.closed = false;
+			pushShelf(std::move(shelf));
+		}
+
+		// Cuboids of a shelf lie on its bottom.
+		const float lastStartY = part.shelves.back().startY;
+		for (Cuboid cuboid : part.usedCuboids)
+		{
+			if (cuboid.y == lastStartY)
+				leftovers.push_back(cuboid);
+			else
+			{
+				cuboid.y += top;
+				usedCuboids.push_back(cuboid);
+				if (placementSink)
+					placementSink->place(cuboid);
+				filledHeight = std::max(filledHeight, cuboid.y + cuboid.height);
+			}
+		}
+		top += lastStartY;
+	}
+
+	if (shelves.empty())
+	{
+		currentY = 0;
+		startNewShelf(0);
+	}
+	else
+		currentY = shelves.back().startY;
+
+	// Fill gaps of stacked shelves with cuboids of the last shelves, in the
+	// order of volumes as the serial algorithm inserts them.
+	stable_sort(leftovers.begin(), leftovers.end(), &Cuboid::compareVolume);
+	size_t total = 0;
+	for (size_t count : notPlaced)
+		total += count;
+	for (const Cuboid& cuboid : leftovers)
+		if (!insert(cuboid, method).isPlaced)
+			++total;
+	return total;
+}
+
 void ShelfAlgorithm::startNewShelf(float startingHeight)
 {
 	if (shelves.size() > 0)
@@ -232,12 +606,15 @@ void ShelfAlgorithm::startNewShelf(float startingHeight)
 		assert(currentY < binHeight);
 	}
 
-	Shelf shelf;
+	Shelf shelf(resource);
 	shelf.height = startingHeight;
 	shelf.startY = currentY;
+	shelf.closed = false;
+	shelf.freeArea = long(int(binWidth)) * int(binDepth);
 
 	shelf.guillotine.init(binWidth, binDepth);
+	shelf.guillotine.setMergeEnabled(mergeEnabled);
 
 	assert(shelf.startY + shelf.height <= binHeight);
-	shelves.push_back(shelf);
+	pushShelf(std::move(shelf));
 }
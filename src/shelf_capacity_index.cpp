@@ -0,0 +1,109 @@
+//============================================================================
+// Name        : shelf_capacity_index.cpp
+// Author      : krris
+// Version     : 1.0
+//============================================================================
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "../include/shelf_capacity_index.hpp"
+
+using namespace std;
+
+/* Summary of no shelf, nothing fits it. */
+static const ShelfCapacityIndex::Capacity emptyCapacity = {
+	-numeric_limits<float>::infinity(), -1, -1
+};
+
+void ShelfCapacityIndex::clear()
+{
+	leaves = 0;
+	shelves = 0;
+	tree.clear();
+}
+
+void ShelfCapacityIndex::push_back(const Capacity& capacity)
+{
+	if (shelves == leaves)
+	{
+		// Double the number of leaves and rebuild inner nodes. New leaves
+		// follow the old ones, so the capacity of the tree is reused after
+		// clear().
+		size_t newLeaves = max<size_t>(1, 2 * leaves);
+		tree.resize(2 * newLeaves, emptyCapacity);
+		for (size_t i = 0; i < shelves; ++i)
+			tree[newLeaves + i] = tree[leaves + i];
+		leaves = newLeaves;
+		for (size_t node = leaves - 1; node > 0; --node)
+			updateParents(node);
+	}
+
+	++shelves;
+	update(shelves - 1, capacity);
+}
+
+void ShelfCapacityIndex::update(size_t shelf, const Capacity& capacity)
+{
+	assert(shelf < shelves);
+	tree[leaves + shelf] = capacity;
+	for (size_t node = (leaves + shelf) / 2; node > 0; node /= 2)
+		updateParents(node);
+}
+
+ShelfCapacityIndex::Capacity ShelfCapacityIndex::summary() const
+{
+	return shelves > 0 ? tree[1] : emptyCapacity;
+}
+
+void ShelfCapacityIndex::updateParents(size_t node)
+{
+	const Capacity& left = tree[2 * node];
+	const Capacity& right = tree[2 * node + 1];
+	tree[node].height = max(left.height, right.height);
+	tree[node].maxShortSide = max(left.maxShortSide, right.maxShortSide);
+	tree[node].maxLongSide = max(left.maxLongSide, right.maxLongSide);
+}
+
+bool ShelfCapacityIndex::mayHold(const Capacity& capacity,
+		const float sortedEdges[3])
+{
+	// Try every edge standing vertically, the two others form the base.
+	for (int v = 0; v < 3; ++v)
+	{
+		if (sortedEdges[v] > capacity.height)
+			continue;
+
+		int a = sortedEdges[v == 0 ? 1 : 0];
+		int b = sortedEdges[v == 2 ? 1 : 2];
+		if (min(a, b) <= capacity.maxShortSide &&
+			max(a, b) <= capacity.maxLongSide)
+			return true;
+	}
+	return false;
+}
+
+size_t ShelfCapacityIndex::findFirst(size_t first,
+		const float sortedEdges[3]) const
+{
+	if (first >= shelves)
+		return shelves;
+	size_t shelf = findFirst(1, 0, leaves, first, sortedEdges);
+	return min(shelf, shelves);
+}
+
+size_t ShelfCapacityIndex::findFirst(size_t node, size_t nodeBegin,
+		size_t nodeEnd, size_t first, const float sortedEdges[3]) const
+{
+	if (nodeEnd <= first || !mayHold(tree[node], sortedEdges))
+		return shelves;
+	if (node >= leaves)
+		return nodeBegin;
+
+	size_t middle = (nodeBegin + nodeEnd) / 2;
+	size_t shelf = findFirst(2 * node, nodeBegin, middle, first, sortedEdges);
+	if (shelf < shelves)
+		return shelf;
+	return findFirst(2 * node + 1, middle, nodeEnd, first, sortedEdges);
+}